@@ -1,859 +1,4567 @@
 #include <SFML/Graphics.hpp>
-#include <stack>
+#include <memory>
 #include <vector>
 #include <random>
 #include <iostream>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstddef>
+#include <cstdarg>
+#include <atomic>
+#include <new>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <climits>
+#include <cmath>
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <map>
+#include <future>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 using namespace std;
 
 #define CELL_WIDTH 20
+#define WALL_THICKNESS 2.f
+#define MAZE_ORIGIN 30
+#define MAX_LAYER_PIXELS (4096 * 4096)
+#define FONT_PATH "Data/Roboto.ttf"
+#define LOBBY_IMAGE_PATH "Data/lobby.jpg"
+#define QUICKSAVE_PATH "quicksave.maze"
+#define PROFILE_FRAMES 240
 
-class Cell {
-public:
-    int x = 0, y = 0;
-    int pos = 0;
-    float size = CELL_WIDTH;
-    float thickness = 2.f;
-    bool walls[4] = { true, true, true, true };
-    bool visited = false;
-    bool isActive = false;
+// Process-wide allocation counters for the benchmark, the profiler and
+// --report-allocations. Only builds with COUNT_ALLOCATIONS (debug builds by
+// default) replace operator new to fill them; elsewhere they stay zero.
+#if !defined(NDEBUG) && !defined(COUNT_ALLOCATIONS)
+#define COUNT_ALLOCATIONS
+#endif
 
-    Cell() {}
-    Cell(int _x, int _y, int _pos) : x(_x), y(_y), pos(_pos) {}
+std::atomic<uint64_t> allocationCount{ 0 };
+std::atomic<uint64_t> allocatedBytes{ 0 };
 
-    void draw(sf::RenderWindow& window) {
-        sf::RectangleShape rect;
+#ifdef COUNT_ALLOCATIONS
+#ifdef _MSC_VER
+#define NOINLINE __declspec(noinline)
+#else
+#define NOINLINE __attribute__((noinline))
+#endif
 
-        if (isActive) {
-            rect.setFillColor(sf::Color(247, 23, 53));
-            rect.setSize({ size, size });
-            rect.setPosition(x, y);
-            window.draw(rect);
-        }
+void* countedAllocation(size_t bytes) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+    return malloc(bytes ? bytes : 1);
+}
 
-        rect.setFillColor(sf::Color(223, 243, 228));
+// Out of line so GCC cannot see operator delete reach free() and warn that
+// it is paired with operator new (-Wmismatched-new-delete)
+NOINLINE void releaseAllocation(void* p) noexcept { free(p); }
 
-        if (walls[0]) {
-            rect.setSize({ size, thickness });
-            rect.setPosition(x, y);
-            window.draw(rect);
-        }
-        if (walls[1]) {
-            rect.setSize({ thickness, size });
-            rect.setPosition(x + size, y);
-            window.draw(rect);
-        }
-        if (walls[2]) {
-            rect.setSize({ size + thickness, thickness });
-            rect.setPosition(x, y + size);
-            window.draw(rect);
-        }
-        if (walls[3]) {
-            rect.setSize({ thickness, size });
-            rect.setPosition(x, y);
-            window.draw(rect);
-        }
-    }
+void* operator new(size_t bytes) {
+    if (void* p = countedAllocation(bytes)) return p;
+    throw std::bad_alloc();
+}
+
+// The nothrow form (used by std::stable_sort's buffer) must pair with the
+// deletes below too
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept { return countedAllocation(bytes); }
+
+void operator delete(void* p) noexcept { releaseAllocation(p); }
+void operator delete(void* p, size_t) noexcept { releaseAllocation(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { releaseAllocation(p); }
+#endif
+
+// Draw calls and vertices submitted through the maze renderer
+struct RenderStats {
+    uint64_t drawCalls = 0;
+    uint64_t vertices = 0;
+
+    void reset() { drawCalls = 0; vertices = 0; }
 };
 
-class Maze {
+RenderStats renderStats;
+
+// Phases of a frame timed by the profiler. Generation is nested inside
+// whichever phase triggered it, so it is not added to the frame total.
+enum ProfilePhase { PHASE_IDLE, PHASE_EVENTS, PHASE_UPDATE, PHASE_RENDER, PHASE_GENERATE, PHASE_COUNT };
+
+const char* const phaseNames[PHASE_COUNT] = { "idle", "events", "update", "render", "generate" };
+
+struct FrameSample {
+    uint64_t frame = 0;
+    int64_t start = 0;                      // microseconds since the profiler was created
+    int64_t duration = 0;
+    int64_t phaseStart[PHASE_COUNT] = {};   // offset of each phase's first entry in the frame
+    int64_t phaseTime[PHASE_COUNT] = {};
+    uint64_t drawCalls = 0;
+    uint64_t vertices = 0;
+    uint64_t allocations = 0;
+    bool rendered = false;
+};
+
+// Per-frame timings and render counts for the last PROFILE_FRAMES frames in a
+// preallocated ring, optionally streamed to a CSV or Chrome trace file. Only
+// the thread that created it (the UI thread) records; other threads are ignored.
+class FrameProfiler {
 private:
-    vector<Cell> cells;
-    int size;
+    sf::Clock epoch;
+    std::thread::id owner = std::this_thread::get_id();
+    vector<FrameSample> ring;
+    uint64_t count = 0;
+    FrameSample current;
+    uint64_t allocationsAtStart = 0;
 
-    void reset() {
-        for (auto& cell : cells) {
-            for (int i = 0; i < 4; i++) cell.walls[i] = true;
-            cell.visited = false;
-            cell.isActive = false;
-        }
+    FILE* trace = nullptr;
+    bool chromeTrace = false;
+    bool firstEvent = true;
+
+    void writeChromeEvent(const char* name, int64_t start, int64_t duration) {
+        fprintf(trace, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%lld,\"dur\":%lld}",
+            firstEvent ? "" : ",\n", name, static_cast<long long>(start), static_cast<long long>(duration));
+        firstEvent = false;
     }
 
-    void removeWalls(Cell& current, Cell& neighbor) {
-        int diff = current.pos - neighbor.pos;
-        if (diff == size) {
-            current.walls[0] = false; neighbor.walls[2] = false;
-        }
-        else if (diff == -1) {
-            current.walls[1] = false; neighbor.walls[3] = false;
-        }
-        else if (diff == -size) {
-            current.walls[2] = false; neighbor.walls[0] = false;
+    void writeTrace(const FrameSample& sample) {
+        if (!chromeTrace) {
+            fprintf(trace, "%llu,%lld,%lld", static_cast<unsigned long long>(sample.frame),
+                static_cast<long long>(sample.start), static_cast<long long>(sample.duration));
+            for (int phase = 0; phase < PHASE_COUNT; phase++) fprintf(trace, ",%lld", static_cast<long long>(sample.phaseTime[phase]));
+            fprintf(trace, ",%llu,%llu,%llu,%d\n", static_cast<unsigned long long>(sample.drawCalls),
+                static_cast<unsigned long long>(sample.vertices), static_cast<unsigned long long>(sample.allocations), sample.rendered ? 1 : 0);
+            return;
         }
-        else if (diff == 1) {
-            current.walls[3] = false; neighbor.walls[1] = false;
+
+        writeChromeEvent("frame", sample.start, sample.duration);
+        for (int phase = 0; phase < PHASE_COUNT; phase++) {
+            if (sample.phaseTime[phase] > 0) writeChromeEvent(phaseNames[phase], sample.start + sample.phaseStart[phase], sample.phaseTime[phase]);
         }
+        fprintf(trace, ",\n{\"name\":\"render stats\",\"ph\":\"C\",\"pid\":1,\"ts\":%lld,\"args\":{\"drawCalls\":%llu,\"vertices\":%llu,\"allocations\":%llu}}",
+            static_cast<long long>(sample.start), static_cast<unsigned long long>(sample.drawCalls),
+            static_cast<unsigned long long>(sample.vertices), static_cast<unsigned long long>(sample.allocations));
     }
 
 public:
-    Maze(int _size) : size(_size) {
-        cells.resize(size * size);
-        for (int row = 0, k = 0; row < size; row++) {
-            for (int col = 0; col < size; col++, k++) {
-                int x = 30 + col * CELL_WIDTH;
-                int y = 30 + row * CELL_WIDTH;
-                cells[k] = Cell(x, y, k);
-            }
-        }
-        generateMaze();
-    }
+    FrameProfiler(size_t capacity = PROFILE_FRAMES) : ring(capacity) {}
+    ~FrameProfiler() { closeTrace(); }
 
-    void generateMaze() {
-        reset();
-        std::stack<Cell*> stack;
-        cells[0].visited = true;
-        stack.push(&cells[0]);
+    int64_t now() const { return epoch.getElapsedTime().asMicroseconds(); }
 
-        while (!stack.empty()) {
-            Cell* current = stack.top();
-            stack.pop();
+    void beginFrame() {
+        current = FrameSample();
+        current.frame = count;
+        current.start = now();
+        renderStats.reset();
+        allocationsAtStart = allocationCount.load(std::memory_order_relaxed);
+    }
 
-            int pos = current->pos;
-            std::vector<int> neighbors;
+    void endFrame(bool rendered) {
+        current.duration = now() - current.start;
+        current.drawCalls = renderStats.drawCalls;
+        current.vertices = renderStats.vertices;
+        current.allocations = allocationCount.load(std::memory_order_relaxed) - allocationsAtStart;
+        current.rendered = rendered;
+        ring[count % ring.size()] = current;
+        count++;
+        if (trace) writeTrace(current);
+    }
 
-            if (pos % size != 0 && !cells[pos - 1].visited) neighbors.push_back(pos - 1);
-            if ((pos + 1) % size != 0 && pos + 1 < size * size && !cells[pos + 1].visited) neighbors.push_back(pos + 1);
-            if (pos + size < size * size && !cells[pos + size].visited) neighbors.push_back(pos + size);
-            if (pos - size >= 0 && !cells[pos - size].visited) neighbors.push_back(pos - size);
+    void record(int phase, int64_t start, int64_t duration) {
+        if (std::this_thread::get_id() != owner) return;
+        if (current.phaseTime[phase] == 0) current.phaseStart[phase] = start - current.start;
+        current.phaseTime[phase] += duration;
+    }
 
-            if (!neighbors.empty()) {
-                stack.push(current);
-                std::random_device rd;
-                std::mt19937 gen(rd());
-                std::uniform_int_distribution<> dist(0, neighbors.size() - 1);
-                int nextPos = neighbors[dist(gen)];
+    size_t frames() const { return static_cast<size_t>(std::min<uint64_t>(count, ring.size())); }
 
-                Cell* neighbor = &cells[nextPos];
-                removeWalls(*current, *neighbor);
-                neighbor->visited = true;
-                stack.push(neighbor);
-            }
+    // recent(0) is the last completed frame
+    const FrameSample& recent(size_t back) const { return ring[(count - 1 - back) % ring.size()]; }
+
+    // A path ending in .json gets Chrome trace events (chrome://tracing, Perfetto); anything else CSV
+    bool openTrace(const char* path) {
+        closeTrace();
+        trace = fopen(path, "w");
+        if (!trace) {
+            cout << "Error opening " << path << std::endl;
+            return false;
+        }
+        size_t length = strlen(path);
+        chromeTrace = length >= 5 && strcmp(path + length - 5, ".json") == 0;
+        firstEvent = true;
+        if (chromeTrace) fprintf(trace, "[\n");
+        else {
+            fprintf(trace, "frame,start_us,duration_us");
+            for (int phase = 0; phase < PHASE_COUNT; phase++) fprintf(trace, ",%s_us", phaseNames[phase]);
+            fprintf(trace, ",draw_calls,vertices,allocations,rendered\n");
         }
+        return true;
     }
 
-    void draw(sf::RenderWindow& window) {
-        for (auto& cell : cells) cell.draw(window);
+    void closeTrace() {
+        if (!trace) return;
+        if (chromeTrace) fprintf(trace, "\n]\n");
+        fclose(trace);
+        trace = nullptr;
     }
+};
 
-    Cell& getCell(int index) { return cells[index]; }
+FrameProfiler profiler;
 
-    int getSize() const { return size; }
+// Adds the lifetime of the scope to a phase of the current frame
+class ProfileScope {
+private:
+    int phase;
+    int64_t start;
+
+public:
+    ProfileScope(int _phase) : phase(_phase), start(profiler.now()) {}
+    ~ProfileScope() { profiler.record(phase, start, profiler.now() - start); }
 };
 
-class MazeAnimation {
+// Peak resident set size of this process in bytes
+size_t peakMemoryBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return counters.PeakWorkingSetSize;
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+// Wall sides, in the order the original per-cell walls[4] array used
+enum Side { TOP = 0, RIGHT = 1, BOTTOM = 2, LEFT = 3 };
+
+// A whole file mapped copy-on-write: pages come straight from the page cache
+// and are only copied when written, and writes never reach the file
+class MappedFile {
 private:
-    sf::RectangleShape miniMaze;
-    vector<sf::RectangleShape> walls;
-    sf::CircleShape player;
-    sf::Vector2f position;
-    sf::Vector2f velocity;
-    float rotation;
-    float rotationSpeed;
+    uint8_t* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
 
 public:
+    MappedFile() {}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { unmap(); }
 
-    MazeAnimation(float x, float y) {
-        position = sf::Vector2f(x, y);
+    bool map(const char* path) {
+        unmap();
+#ifdef _WIN32
+        file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) { unmap(); return false; }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (!mapping) { unmap(); return false; }
+        bytes = static_cast<uint8_t*>(MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0));
+        if (!bytes) { unmap(); return false; }
+        length = static_cast<size_t>(fileSize.QuadPart);
+#else
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) { ::close(fd); return false; }
+        void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (view == MAP_FAILED) return false;
+        bytes = static_cast<uint8_t*>(view);
+        length = static_cast<size_t>(info.st_size);
+#endif
+        return true;
+    }
 
-        // Create mini maze
-        miniMaze.setSize(sf::Vector2f(120, 120));
-        miniMaze.setFillColor(sf::Color(20, 20, 40));
-        miniMaze.setOutlineThickness(3);
-        miniMaze.setOutlineColor(sf::Color(100, 100, 200));
-        miniMaze.setOrigin(60, 60);
+    void unmap() {
+#ifdef _WIN32
+        if (bytes) UnmapViewOfFile(bytes);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (bytes) munmap(bytes, length);
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
 
-        // Create some walls inside the mini maze
-        for (int i = 0; i < 6; i++) {
-            sf::RectangleShape wall;
-            wall.setFillColor(sf::Color(223, 243, 228));
+    uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+};
 
-            if (i % 2 == 0) {
-                // Horizontal walls
-                wall.setSize(sf::Vector2f(40, 4));
-                wall.setPosition(-20 + (i / 2) * 10, -30 + (i / 2) * 15);
-            }
-            else {
-                // Vertical walls
-                wall.setSize(sf::Vector2f(4, 40));
-                wall.setPosition(-30 + ((i - 1) / 2) * 20, -20 + ((i - 1) / 2) * 15);
-            }
-            walls.push_back(wall);
-        }
+// Compact maze state: a 4-bit wall mask per cell (two cells per byte) plus
+// one visited bit per cell. Pixel geometry is derived when rendering.
+class MazeGrid {
+private:
+    int width = 0, height = 0;
+    vector<uint8_t> walls;
+    vector<uint64_t> visited;
 
-        // Create player dot
-        player.setRadius(5);
-        player.setFillColor(sf::Color(247, 23, 53));
-        player.setOrigin(5, 5);
-        player.setPosition(0, 0);
+    // The wall bytes in use: walls.data(), or a region of a mapped maze file
+    uint8_t* wallBytes = nullptr;
+    std::shared_ptr<MappedFile> mapping;
 
-        // Initialize animation properties
-        velocity = sf::Vector2f(1.0f, 1.5f);
-        rotation = 0.0f;
-        rotationSpeed = 0.2f;
+public:
+    MazeGrid() {}
+    MazeGrid(int _width, int _height) { resize(_width, _height); }
+
+    // Copies always own their walls, even when the source runs from a mapping
+    MazeGrid(const MazeGrid& other) { *this = other; }
+    MazeGrid(MazeGrid&& other) noexcept { *this = std::move(other); }
+
+    MazeGrid& operator=(const MazeGrid& other) {
+        if (this == &other) return *this;
+        width = other.width;
+        height = other.height;
+        walls.assign(other.wallBytes, other.wallBytes + other.packedSize());
+        visited = other.visited;
+        mapping.reset();
+        wallBytes = walls.data();
+        return *this;
     }
 
-    void update() {
-        // Update position
-        position += velocity;
+    MazeGrid& operator=(MazeGrid&& other) noexcept {
+        if (this == &other) return *this;
+        width = other.width;
+        height = other.height;
+        walls = std::move(other.walls);
+        visited = std::move(other.visited);
+        mapping = std::move(other.mapping);
+        wallBytes = other.wallBytes;
+        other.width = other.height = 0;
+        other.wallBytes = nullptr;
+        return *this;
+    }
 
-        // Bounce off screen edges
-        if (position.x < 200 || position.x > 1080) {
-            velocity.x = -velocity.x;
-        }
+    void resize(int _width, int _height) {
+        width = _width;
+        height = _height;
+        size_t count = static_cast<size_t>(width) * height;
+        walls.assign((count + 1) / 2, 0xFF);
+        visited.assign((count + 63) / 64, 0);
+        mapping.reset();
+        wallBytes = walls.data();
+    }
 
-        if (position.y < 250 || position.y > 550) {
-            velocity.y = -velocity.y;
-        }
+    // Runs the grid in place from packed walls inside a mapped file. Writes land
+    // in private copy-on-write pages; visited bits are allocated by reset().
+    void attach(std::shared_ptr<MappedFile> file, size_t offset, int _width, int _height) {
+        width = _width;
+        height = _height;
+        vector<uint8_t>().swap(walls);
+        vector<uint64_t>().swap(visited);
+        mapping = std::move(file);
+        wallBytes = mapping->data() + offset;
+    }
 
-        // Rotate the maze
-        rotation += rotationSpeed;
+    // Closes every wall and clears the visited bits
+    void reset() {
+        std::fill(wallBytes, wallBytes + packedSize(), 0xFF);
+        visited.assign((static_cast<size_t>(width) * height + 63) / 64, 0);
+    }
 
-        // Move player inside the maze in a circular pattern
-        float playerRadius = 30;
-        float playerX = cos(rotation * 2) * playerRadius;
-        float playerY = sin(rotation * 2) * playerRadius;
-        player.setPosition(playerX, playerY);
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int cellCount() const { return width * height; }
+
+    // Heap bytes only; a mapped grid's walls live in the page cache
+    size_t memoryBytes() const { return walls.size() + visited.size() * sizeof(uint64_t); }
+
+    // The packed walls, two cells per byte with the even cell in the low nibble
+    const uint8_t* packedWalls() const { return wallBytes; }
+    size_t packedSize() const { return (static_cast<size_t>(width) * height + 1) / 2; }
+    bool isMapped() const { return mapping != nullptr; }
+
+    int wallMask(int pos) const { return (wallBytes[pos >> 1] >> ((pos & 1) << 2)) & 0xF; }
+    bool hasWall(int pos, int side) const { return (wallMask(pos) >> side) & 1; }
+
+    void setWallMask(int pos, int mask) {
+        int shift = (pos & 1) << 2;
+        wallBytes[pos >> 1] = static_cast<uint8_t>((wallBytes[pos >> 1] & ~(0xF << shift)) | ((mask & 0xF) << shift));
     }
 
-    void draw(sf::RenderWindow& window) {
-        // Save current transform
-        sf::Transform transform;
-        transform.translate(position);
-        transform.rotate(rotation);
+    void clearWall(int pos, int side) { wallBytes[pos >> 1] &= static_cast<uint8_t>(~(1 << (side + ((pos & 1) << 2)))); }
 
-        // Draw the maze
-        window.draw(miniMaze, transform);
+    // True when no cell opens off the edge of the grid. Solvers and the goal
+    // field step through open sides without bounds checks, so loaded grids must pass.
+    bool bordersClosed() const {
+        for (int x = 0; x < width; x++) {
+            if (!hasWall(x, TOP) || !hasWall((height - 1) * width + x, BOTTOM)) return false;
+        }
+        for (int y = 0; y < height; y++) {
+            if (!hasWall(y * width, LEFT) || !hasWall(y * width + width - 1, RIGHT)) return false;
+        }
+        return true;
+    }
 
-        // Draw the walls
-        for (auto& wall : walls) {
-            window.draw(wall, transform);
+    // True when every shared wall is recorded the same way on both sides
+    bool wallsAgree() const {
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int pos = y * width + x;
+                if (x + 1 < width && hasWall(pos, RIGHT) != hasWall(pos + 1, LEFT)) return false;
+                if (y + 1 < height && hasWall(pos, BOTTOM) != hasWall(pos + width, TOP)) return false;
+            }
         }
+        return true;
+    }
 
-        // Draw the player
-        window.draw(player, transform);
+    // True for a spanning tree: exactly cells - 1 openings and every cell
+    // reachable from cell 0, so there are no loops. Assumes closed borders and
+    // agreeing walls. Guidance and the junction graph rely on this.
+    bool isPerfect() const {
+        long long openings = 0;
+        for (int pos = 0; pos < cellCount(); pos++) {
+            openings += !hasWall(pos, RIGHT) + !hasWall(pos, BOTTOM);
+        }
+        if (openings != cellCount() - 1LL) return false;
+
+        vector<uint64_t> seen((static_cast<size_t>(cellCount()) + 63) / 64, 0);
+        vector<int> stack = { 0 };
+        seen[0] = 1;
+        int reached = 1;
+        const int offsets[4] = { -width, 1, width, -1 };
+        while (!stack.empty()) {
+            int pos = stack.back();
+            stack.pop_back();
+            for (int side = 0; side < 4; side++) {
+                if (hasWall(pos, side)) continue;
+                int next = pos + offsets[side];
+                if ((seen[next >> 6] >> (next & 63)) & 1) continue;
+                seen[next >> 6] |= uint64_t(1) << (next & 63);
+                stack.push_back(next);
+                reached++;
+            }
+        }
+        return reached == cellCount();
     }
-};
 
-class Lobby {
-private:
-    sf::RenderWindow& window;
-    sf::Font font;
-    sf::Text title;
-    sf::Text startText;
-    sf::Text exitText;
-    sf::RectangleShape startButton;
-    sf::RectangleShape exitButton;
-    bool startgame;
-    sf::Texture lobbyimage;
-	sf::Sprite lobbySprite;
+    bool isVisited(int pos) const { return (visited[pos >> 6] >> (pos & 63)) & 1; }
+    void setVisited(int pos) { visited[pos >> 6] |= uint64_t(1) << (pos & 63); }
 
-    // Hover state tracking
-    bool startHovered;
-    bool exitHovered;
+    // Copies another grid's walls in with its top-left cell at (x0, y0)
+    void blit(const MazeGrid& source, int x0, int y0) {
+        for (int y = 0; y < source.height; y++) {
+            for (int x = 0; x < source.width; x++) {
+                setWallMask((y0 + y) * width + x0 + x, source.wallMask(y * source.width + x));
+            }
+        }
+    }
 
-    // Animation
-    MazeAnimation mazeAnimation1;
-    MazeAnimation mazeAnimation2;
-    MazeAnimation mazeAnimation3;
+    // FNV-1a over the wall bits; equal hashes mean identical mazes
+    uint64_t hash() const {
+        uint64_t h = 14695981039346656037ULL;
+        for (size_t i = 0, n = packedSize(); i < n; i++) h = (h ^ wallBytes[i]) * 1099511628211ULL;
+        return h;
+    }
 
-public:
-    Lobby(sf::RenderWindow& window) :
-        window(window),
-        startgame(false),
-        startHovered(false),
-        exitHovered(false),
-        mazeAnimation1(200, 350),
-        mazeAnimation2(window.getSize().x - 200, 250),
-        mazeAnimation3(window.getSize().x / 2, 550)
-    {
-        if (!font.loadFromFile("Data/Roboto.ttf")) {
-            cout << "Error loading font" << std::endl;
+    // Knocks down the shared wall between two orthogonally adjacent cells.
+    // Vertical moves are tested first so one-column grids are unambiguous.
+    void removeWallBetween(int current, int neighbor) {
+        int diff = current - neighbor;
+        if (diff == width) {
+            clearWall(current, TOP); clearWall(neighbor, BOTTOM);
+        }
+        else if (diff == -width) {
+            clearWall(current, BOTTOM); clearWall(neighbor, TOP);
         }
-		if (!lobbyimage.loadFromFile("Data/lobby.jpg")) {
-			cout << "Error loading image" << std::endl;
-		}
-		
+        else if (diff == -1) {
+            clearWall(current, RIGHT); clearWall(neighbor, LEFT);
+        }
+        else if (diff == 1) {
+            clearWall(current, LEFT); clearWall(neighbor, RIGHT);
+        }
+    }
+};
 
-        title.setFont(font);
-        title.setString("Maze Game");
-        title.setCharacterSize(80);
-        title.setFillColor(sf::Color::Yellow);
-        title.setPosition(window.getSize().x / 2 - title.getGlobalBounds().width / 2, 100);
+// Maze file, version 1: a 64-byte header, then at a page-aligned offset the
+// packed walls exactly as MazeGrid holds them, so a file is mapped and used in
+// place with no parsing. Fields are in host byte order (little-endian on every
+// supported platform).
+#define MAZE_FILE_MAGIC 0x425A414D   // "MAZB"
+#define MAZE_FILE_VERSION 1
+#define MAZE_FILE_ALIGN 4096
 
-        // Start button setup
-        startText.setFont(font);
-        startText.setString("Press Enter to Start");
-        startText.setCharacterSize(30);
-        startText.setFillColor(sf::Color::White);
+struct MazeFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    int32_t width;
+    int32_t height;
+    int32_t generatorId;
+    uint64_t seed;
+    uint64_t wallsOffset;
+    uint64_t wallsSize;
+    uint64_t wallsHash;     // MazeGrid::hash() of the walls, checked only on request
+    uint32_t reserved;
+    uint32_t checksum;      // FNV-1a over every header byte before this field
+};
 
-        // Exit button setup
-        exitText.setFont(font);
-        exitText.setString("Press Escape to Exit");
-        exitText.setCharacterSize(30);
-        exitText.setFillColor(sf::Color::White);
+static_assert(sizeof(MazeFileHeader) == 64, "maze file header layout changed");
 
-        // Create button rectangles
-        const float padding = 20.0f;
-        startButton.setSize({ startText.getGlobalBounds().width + padding * 2, startText.getGlobalBounds().height + padding * 2 });
-        startButton.setFillColor(sf::Color(50, 50, 100));
-        startButton.setOutlineThickness(2);
-        startButton.setOutlineColor(sf::Color(100, 100, 200));
+uint32_t mazeHeaderChecksum(const MazeFileHeader& header) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&header);
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < offsetof(MazeFileHeader, checksum); i++) h = (h ^ bytes[i]) * 16777619u;
+    return h;
+}
 
-        exitButton.setSize({ exitText.getGlobalBounds().width + padding * 2, exitText.getGlobalBounds().height + padding * 2 });
-        exitButton.setFillColor(sf::Color(100, 50, 50));
-        exitButton.setOutlineThickness(2);
-        exitButton.setOutlineColor(sf::Color(200, 100, 100));
+bool saveMazeFile(const char* path, const MazeGrid& grid, uint64_t seed, int generatorId) {
+    MazeFileHeader header = {};
+    header.magic = MAZE_FILE_MAGIC;
+    header.version = MAZE_FILE_VERSION;
+    header.headerSize = sizeof(MazeFileHeader);
+    header.width = grid.getWidth();
+    header.height = grid.getHeight();
+    header.generatorId = generatorId;
+    header.seed = seed;
+    header.wallsOffset = MAZE_FILE_ALIGN;
+    header.wallsSize = grid.packedSize();
+    header.wallsHash = grid.hash();
+    header.checksum = mazeHeaderChecksum(header);
 
-        // Position the buttons
-        startButton.setPosition(window.getSize().x / 2 - startButton.getSize().x / 2, 300);
-        exitButton.setPosition(window.getSize().x / 2 - exitButton.getSize().x / 2, 400);
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        cout << "Error opening " << path << std::endl;
+        return false;
+    }
+    static const uint8_t padding[MAZE_FILE_ALIGN - sizeof(MazeFileHeader)] = {};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(padding, sizeof(padding), 1, file) == 1
+        && fwrite(grid.packedWalls(), 1, header.wallsSize, file) == header.wallsSize;
+    ok = fclose(file) == 0 && ok;
+    if (!ok) cout << "Error writing " << path << std::endl;
+    return ok;
+}
 
-        // Position the text in the middle of the buttons
-        startText.setPosition(
-            startButton.getPosition().x + (startButton.getSize().x - startText.getGlobalBounds().width) / 2,
-            startButton.getPosition().y + (startButton.getSize().y - startText.getGlobalBounds().height) / 2 - 15
-        );
+// Maps a maze file and points grid at its walls. The walls are read once to
+// reject anything but a perfect maze: the solvers, the goal field and the
+// junction graph step through open sides unchecked and assume no loops.
+bool loadMazeFile(const char* path, MazeGrid& grid, MazeFileHeader& header) {
+    auto file = std::make_shared<MappedFile>();
+    if (!file->map(path)) {
+        cout << "Error opening " << path << std::endl;
+        return false;
+    }
+    if (file->size() < sizeof(MazeFileHeader)) {
+        cout << path << ": not a maze file" << std::endl;
+        return false;
+    }
+    memcpy(&header, file->data(), sizeof(header));
+    if (header.magic != MAZE_FILE_MAGIC || header.headerSize != sizeof(MazeFileHeader)) {
+        cout << path << ": not a maze file" << std::endl;
+        return false;
+    }
+    if (header.version != MAZE_FILE_VERSION) {
+        cout << path << ": unsupported maze file version " << header.version << std::endl;
+        return false;
+    }
+    if (header.checksum != mazeHeaderChecksum(header)) {
+        cout << path << ": header checksum mismatch" << std::endl;
+        return false;
+    }
 
-        exitText.setPosition(
-            exitButton.getPosition().x + (exitButton.getSize().x - exitText.getGlobalBounds().width) / 2,
-            exitButton.getPosition().y + (exitButton.getSize().y - exitText.getGlobalBounds().height) / 2 - 15
-        );
+    long long cells = static_cast<long long>(header.width) * header.height;
+    if (header.width <= 0 || header.height <= 0 || cells > INT_MAX
+        || header.wallsSize != static_cast<uint64_t>((cells + 1) / 2)
+        || header.wallsOffset < sizeof(MazeFileHeader)
+        || header.wallsOffset > file->size()
+        || header.wallsSize > file->size() - header.wallsOffset) {
+        cout << path << ": corrupt maze file" << std::endl;
+        return false;
     }
 
-    bool run() {
-        while (window.isOpen()) {
-            handlevent();
-            update();
-            render();
-            if (startgame) return true;
-        }
+    grid.attach(std::move(file), static_cast<size_t>(header.wallsOffset), header.width, header.height);
+    if (!grid.bordersClosed()) {
+        cout << path << ": corrupt maze file, the outer wall is open" << std::endl;
+        grid = MazeGrid();
+        return false;
+    }
+    if (!grid.wallsAgree() || !grid.isPerfect()) {
+        cout << path << ": corrupt maze file, the walls do not form a perfect maze" << std::endl;
+        grid = MazeGrid();
         return false;
     }
+    return true;
+}
 
-    void update() {
-        // Update animations
-        mazeAnimation1.update();
-        mazeAnimation2.update();
-        mazeAnimation3.update();
+// PCG32 (XSH-RR). Small, fast and bit-identical on every platform for a given
+// seed, unlike std::random_device/mt19937 plus the library's distributions.
+class Pcg32 {
+private:
+    uint64_t state = 0;
+    uint64_t inc = 1;
+
+public:
+    Pcg32(uint64_t seed = 0x853c49e6748fea9bULL, uint64_t stream = 0xda3e39cb94b95bdbULL) {
+        inc = (stream << 1) | 1;
+        next();
+        state += seed;
+        next();
     }
 
-    void handlevent() {
-        sf::Event event;
-        while (window.pollEvent(event)) {
-            if (event.type == sf::Event::Closed) window.close();
-            if (event.type == sf::Event::KeyPressed) {
-                if (event.key.code == sf::Keyboard::Enter) startgame = true;
-                else if (event.key.code == sf::Keyboard::Escape) window.close();
-            }
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + inc;
+        uint32_t xorshifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+        uint32_t rot = static_cast<uint32_t>(old >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+    }
 
-            // Handle mouse movement for hover effects
-            if (event.type == sf::Event::MouseMoved) {
-                sf::Vector2f mousePos(event.mouseMove.x, event.mouseMove.y);
-                startHovered = startButton.getGlobalBounds().contains(mousePos);
-                exitHovered = exitButton.getGlobalBounds().contains(mousePos);
-            }
+    uint64_t next64() { return (static_cast<uint64_t>(next()) << 32) | next(); }
 
-            // Handle mouse clicks on buttons
-            if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
-                sf::Vector2f mousePos(event.mouseButton.x, event.mouseButton.y);
-                if (startButton.getGlobalBounds().contains(mousePos)) startgame = true;
-                if (exitButton.getGlobalBounds().contains(mousePos)) window.close();
+    // Unbiased value in [0, bound) using Lemire's multiply-and-reject
+    uint32_t below(uint32_t bound) {
+        uint64_t m = static_cast<uint64_t>(next()) * bound;
+        uint32_t low = static_cast<uint32_t>(m);
+        if (low < bound) {
+            uint32_t threshold = (0u - bound) % bound;
+            while (low < threshold) {
+                m = static_cast<uint64_t>(next()) * bound;
+                low = static_cast<uint32_t>(m);
             }
         }
-
-        // Update button colors based on hover status
-        startButton.setFillColor(startHovered ? sf::Color(80, 80, 180) : sf::Color(50, 50, 100));
-        exitButton.setFillColor(exitHovered ? sf::Color(180, 80, 80) : sf::Color(100, 50, 50));
+        return static_cast<uint32_t>(m >> 32);
     }
+};
 
-    void render() {
-        window.clear(sf::Color(13, 2, 33));
+// Fixed set of worker threads with a task deque each. A worker takes its own
+// newest task first, which keeps nested work cache-warm, and when it runs dry
+// steals the oldest task of another worker or the queue fed by outside threads.
+// Threads waiting on a parallelFor run pending tasks meanwhile, so nested
+// parallel loops cannot starve the pool.
+class ThreadPool {
+private:
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
 
-        // Draw animated mazes
-        mazeAnimation1.draw(window);
-        mazeAnimation2.draw(window);
-        mazeAnimation3.draw(window);
+    struct WorkerSlot {
+        ThreadPool* pool = nullptr;
+        int index = -1;
+    };
 
-        window.draw(title);
-        window.draw(startButton);
-        window.draw(exitButton);
-        window.draw(startText);
-        window.draw(exitText);
-		window.draw(lobbySprite);
-        window.display();
+    vector<std::thread> workers;
+    vector<std::unique_ptr<TaskQueue>> queues;   // one per worker, then the shared injection queue
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<int> pending{ 0 };
+    bool stopping = false;
+
+    static WorkerSlot& currentWorker() {
+        static thread_local WorkerSlot slot;
+        return slot;
     }
-};
-class LevelSelector {
-private:
-    sf::RenderWindow& window;
-    sf::Font font;
-    sf::Text title, easyText, mediumText, hardText;
-    sf::RectangleShape easyButton, mediumButton, hardButton;
-    bool easyHovered, mediumHovered, hardHovered;
-    MazeAnimation mazeAnimation1;
+
+    // This thread's own queue index if it is one of our workers, else -1
+    int ownIndex() const {
+        const WorkerSlot& slot = currentWorker();
+        return slot.pool == this ? slot.index : -1;
+    }
+
+    bool take(TaskQueue& queue, bool newest, std::function<void()>& task) {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) return false;
+        if (newest) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        pending--;
+        return true;
+    }
+
+    // Runs one task from anywhere in the pool; false if there was none
+    bool runPending() {
+        int self = ownIndex(), count = static_cast<int>(queues.size());
+        std::function<void()> task;
+        bool found = self >= 0 && take(*queues[self], true, task);
+        for (int i = 1; !found && i <= count; i++) {
+            int victim = ((self < 0 ? 0 : self) + i) % count;
+            found = take(*queues[victim], false, task);
+        }
+        if (found) task();
+        return found;
+    }
+
+    void workerLoop(int index) {
+        currentWorker() = { this, index };
+        while (true) {
+            if (runPending()) continue;
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this] { return stopping || pending > 0; });
+            if (stopping && pending == 0) return;
+        }
+    }
+
+public:
+    ThreadPool(int threads = 0) {
+        if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (int i = 0; i <= threads; i++) queues.push_back(std::make_unique<TaskQueue>());
+        for (int i = 0; i < threads; i++) workers.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    int size() const { return static_cast<int>(workers.size()); }
+
+    void submit(std::function<void()> task) {
+        int self = ownIndex();
+        TaskQueue& queue = *queues[self >= 0 ? self : size()];
+
+        // Counted before it is visible, so pending never undercounts a queued task
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            pending++;
+        }
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+        wake.notify_one();
+    }
+
+    // Runs body(i) for every i in [0, count) and returns once all have finished.
+    // The calling thread helps, so this is safe to use from inside a pool task.
+    void parallelFor(int count, const std::function<void(int)>& body) {
+        std::atomic<int> next{ 0 };
+        std::atomic<int> finished{ 0 };
+        int helpers = std::min(size(), count - 1);
+
+        auto drain = [&] {
+            for (int i = next.fetch_add(1); i < count; i = next.fetch_add(1)) body(i);
+        };
+        for (int h = 0; h < helpers; h++) {
+            submit([&] {
+                drain();
+                finished++;
+            });
+        }
+        drain();
+
+        // Helpers still queued are run or stolen here rather than waited for
+        while (finished.load() < helpers) {
+            if (!runPending()) std::this_thread::yield();
+        }
+    }
+};
+
+ThreadPool& sharedPool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+// SplitMix64 finaliser: derives independent, well-mixed seeds from one seed
+uint64_t mixSeed(uint64_t seed, uint64_t index) {
+    uint64_t z = seed + (index + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Grid geometry for the hot kernels. FixedShape knows its size at compile
+// time: neighbour offsets are constants and the sides leading off the grid
+// come from a constexpr table, so its kernels have no division and no size
+// comparisons. RuntimeShape is the fallback for every other size.
+template <int W, int H = W>
+struct FixedShape {
+    static constexpr int width = W;
+    static constexpr int height = H;
+    static constexpr int count = W * H;
+
+    struct Tables {
+        int offsets[4];
+        uint8_t border[W * H];   // bit per side that leads off the grid
+    };
+
+    static constexpr Tables makeTables() {
+        Tables tables{};
+        tables.offsets[TOP] = -W;
+        tables.offsets[RIGHT] = 1;
+        tables.offsets[BOTTOM] = W;
+        tables.offsets[LEFT] = -1;
+        for (int pos = 0; pos < count; pos++) {
+            int col = pos % W, row = pos / W;
+            tables.border[pos] = static_cast<uint8_t>((row == 0 ? 1 << TOP : 0) | (col == W - 1 ? 1 << RIGHT : 0) |
+                (row == H - 1 ? 1 << BOTTOM : 0) | (col == 0 ? 1 << LEFT : 0));
+        }
+        return tables;
+    }
+
+    static constexpr Tables tables = makeTables();
+
+    int border(int pos) const { return tables.border[pos]; }
+    int offset(int side) const { return tables.offsets[side]; }
+};
+
+struct RuntimeShape {
+    int width, height, count;
+    int offsets[4];
+
+    RuntimeShape(int _width, int _height) : width(_width), height(_height), count(_width * _height),
+        offsets{ -_width, 1, _width, -1 } {}
+
+    int border(int pos) const {
+        int col = pos % width;
+        return (pos < width ? 1 << TOP : 0) | (col == width - 1 ? 1 << RIGHT : 0) |
+            (pos >= count - width ? 1 << BOTTOM : 0) | (col == 0 ? 1 << LEFT : 0);
+    }
+    int offset(int side) const { return offsets[side]; }
+};
+
+// Runs body with the compile-time shape of a preset level size, else a runtime one
+template <typename Body>
+auto withShape(int width, int height, Body&& body) {
+    if (width == height) {
+        if (width == 15) return body(FixedShape<15>());
+        if (width == 25) return body(FixedShape<25>());
+        if (width == 35) return body(FixedShape<35>());
+    }
+    return body(RuntimeShape(width, height));
+}
+
+// The cell one step through `side`, or -1 when a wall or the grid edge is in the way
+template <typename Shape>
+int stepThrough(const Shape& shape, const MazeGrid& grid, int pos, int side) {
+    int blocked = shape.border(pos) | grid.wallMask(pos);
+    return (blocked >> side) & 1 ? -1 : pos + shape.offset(side);
+}
+
+// A maze-carving algorithm. generate() receives a grid with every wall closed
+// and no cell visited, and must leave a perfect maze (one spanning tree).
+class MazeGenerator {
+public:
+    virtual ~MazeGenerator() {}
+    virtual const char* name() const = 0;
+    virtual void generate(MazeGrid& grid, Pcg32& rng) = 0;
+};
+
+// Depth-first recursive backtracker, driven by an explicit stack
+class BacktrackerGenerator : public MazeGenerator {
+private:
+    vector<int> stack;
+
+public:
+    const char* name() const override { return "backtracker"; }
+
+    void generate(MazeGrid& grid, Pcg32& rng) override {
+        withShape(grid.getWidth(), grid.getHeight(), [&](const auto& shape) { carve(shape, grid, rng); });
+    }
+
+    // Neighbours are tried left, right, down, up as they always have been, so
+    // every seed carves the same maze at any size and through either shape
+    template <typename Shape>
+    void carve(const Shape& shape, MazeGrid& grid, Pcg32& rng) {
+        stack.clear();
+        grid.setVisited(0);
+        stack.push_back(0);
+
+        while (!stack.empty()) {
+            int pos = stack.back();
+            int border = shape.border(pos);
+
+            int sides[4];
+            int n = 0;
+            if (!(border & (1 << LEFT)) && !grid.isVisited(pos - 1)) sides[n++] = LEFT;
+            if (!(border & (1 << RIGHT)) && !grid.isVisited(pos + 1)) sides[n++] = RIGHT;
+            if (!(border & (1 << BOTTOM)) && !grid.isVisited(pos + shape.offset(BOTTOM))) sides[n++] = BOTTOM;
+            if (!(border & (1 << TOP)) && !grid.isVisited(pos + shape.offset(TOP))) sides[n++] = TOP;
+
+            if (n == 0) {
+                stack.pop_back();
+                continue;
+            }
+            int side = sides[rng.below(n)];
+            int next = pos + shape.offset(side);
+            grid.clearWall(pos, side);
+            grid.clearWall(next, (side + 2) & 3);
+            grid.setVisited(next);
+            stack.push_back(next);
+        }
+    }
+};
+
+// Randomized Kruskal: shuffle every interior wall, knock it down when it joins two sets
+class KruskalGenerator : public MazeGenerator {
+private:
+    vector<int> edges;
+    vector<int> parent;
+
+    int find(int x) {
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    }
+
+public:
+    const char* name() const override { return "kruskal"; }
+
+    void generate(MazeGrid& grid, Pcg32& rng) override {
+        int width = grid.getWidth(), height = grid.getHeight(), count = grid.cellCount();
+
+        // Edge e joins cell e/2 with its right (e even) or lower (e odd) neighbour
+        edges.clear();
+        for (int pos = 0; pos < count; pos++) {
+            if (pos % width != width - 1) edges.push_back(pos * 2);
+            if (pos / width != height - 1) edges.push_back(pos * 2 + 1);
+        }
+        for (int i = static_cast<int>(edges.size()) - 1; i > 0; i--) std::swap(edges[i], edges[rng.below(i + 1)]);
+
+        parent.resize(count);
+        for (int i = 0; i < count; i++) parent[i] = i;
+
+        for (int edge : edges) {
+            int a = edge / 2;
+            int b = (edge & 1) ? a + width : a + 1;
+            int rootA = find(a), rootB = find(b);
+            if (rootA == rootB) continue;
+            parent[rootA] = rootB;
+            grid.removeWallBetween(a, b);
+        }
+    }
+};
+
+// Randomized Prim: grow one tree by attaching a random frontier cell each step
+class PrimGenerator : public MazeGenerator {
+private:
+    vector<int> frontier;
+    vector<uint8_t> inFrontier;
+
+    void addFrontier(MazeGrid& grid, int pos) {
+        if (grid.isVisited(pos) || inFrontier[pos]) return;
+        inFrontier[pos] = 1;
+        frontier.push_back(pos);
+    }
+
+    void addNeighbors(MazeGrid& grid, int pos) {
+        int width = grid.getWidth(), count = grid.cellCount();
+        int col = pos % width;
+        if (col != 0) addFrontier(grid, pos - 1);
+        if (col != width - 1) addFrontier(grid, pos + 1);
+        if (pos - width >= 0) addFrontier(grid, pos - width);
+        if (pos + width < count) addFrontier(grid, pos + width);
+    }
+
+public:
+    const char* name() const override { return "prim"; }
+
+    void generate(MazeGrid& grid, Pcg32& rng) override {
+        int width = grid.getWidth(), count = grid.cellCount();
+        frontier.clear();
+        inFrontier.assign(count, 0);
+
+        int start = rng.below(count);
+        grid.setVisited(start);
+        addNeighbors(grid, start);
+
+        while (!frontier.empty()) {
+            int index = rng.below(static_cast<uint32_t>(frontier.size()));
+            int pos = frontier[index];
+            frontier[index] = frontier.back();
+            frontier.pop_back();
+
+            int col = pos % width;
+            int inMaze[4];
+            int n = 0;
+            if (col != 0 && grid.isVisited(pos - 1)) inMaze[n++] = pos - 1;
+            if (col != width - 1 && grid.isVisited(pos + 1)) inMaze[n++] = pos + 1;
+            if (pos - width >= 0 && grid.isVisited(pos - width)) inMaze[n++] = pos - width;
+            if (pos + width < count && grid.isVisited(pos + width)) inMaze[n++] = pos + width;
+
+            grid.removeWallBetween(pos, inMaze[rng.below(n)]);
+            grid.setVisited(pos);
+            addNeighbors(grid, pos);
+        }
+    }
+};
+
+// Wilson's algorithm: loop-erased random walks, giving a uniform spanning tree
+class WilsonGenerator : public MazeGenerator {
+private:
+    vector<int> nextStep;
+
+public:
+    const char* name() const override { return "wilson"; }
+
+    void generate(MazeGrid& grid, Pcg32& rng) override {
+        int width = grid.getWidth(), count = grid.cellCount();
+        nextStep.assign(count, -1);
+        grid.setVisited(rng.below(count));
+
+        for (int start = 0; start < count; start++) {
+            if (grid.isVisited(start)) continue;
+
+            // Walk until the tree is hit; overwriting nextStep erases any loops
+            int pos = start;
+            while (!grid.isVisited(pos)) {
+                int col = pos % width;
+                int options[4];
+                int n = 0;
+                if (col != 0) options[n++] = pos - 1;
+                if (col != width - 1) options[n++] = pos + 1;
+                if (pos - width >= 0) options[n++] = pos - width;
+                if (pos + width < count) options[n++] = pos + width;
+                nextStep[pos] = options[rng.below(n)];
+                pos = nextStep[pos];
+            }
+
+            for (pos = start; !grid.isVisited(pos); pos = nextStep[pos]) {
+                grid.removeWallBetween(pos, nextStep[pos]);
+                grid.setVisited(pos);
+            }
+        }
+    }
+};
+
+// Binary tree: every cell carves either up or left. Very fast, strongly biased.
+class BinaryTreeGenerator : public MazeGenerator {
+public:
+    const char* name() const override { return "binarytree"; }
+
+    void generate(MazeGrid& grid, Pcg32& rng) override {
+        int width = grid.getWidth(), count = grid.cellCount();
+        for (int pos = 0; pos < count; pos++) {
+            bool canUp = pos >= width, canLeft = pos % width != 0;
+            if (canUp && (!canLeft || rng.below(2) == 0)) grid.removeWallBetween(pos, pos - width);
+            else if (canLeft) grid.removeWallBetween(pos, pos - 1);
+        }
+    }
+};
+
+// Sidewinder: carve runs along each row, closing every run with one passage up
+class SidewinderGenerator : public MazeGenerator {
+public:
+    const char* name() const override { return "sidewinder"; }
+
+    void generate(MazeGrid& grid, Pcg32& rng) override {
+        int width = grid.getWidth(), height = grid.getHeight();
+        for (int row = 0; row < height; row++) {
+            int runStart = 0;
+            for (int col = 0; col < width; col++) {
+                int pos = row * width + col;
+                bool atEnd = col == width - 1;
+                if (row == 0) {
+                    if (!atEnd) grid.removeWallBetween(pos, pos + 1);
+                    continue;
+                }
+                if (!atEnd && rng.below(2) == 0) {
+                    grid.removeWallBetween(pos, pos + 1);
+                    continue;
+                }
+                int up = row * width + runStart + rng.below(col - runStart + 1);
+                grid.removeWallBetween(up, up - width);
+                runStart = col + 1;
+            }
+        }
+    }
+};
+
+// Receives a streamed maze one row at a time; walls holds one 4-bit mask per cell
+class MazeRowSink {
+public:
+    virtual ~MazeRowSink() {}
+    virtual void consumeRow(long long row, const uint8_t* walls, int width) = 0;
+};
+
+// Eller's algorithm: produces a perfect maze row by row while keeping only the
+// current row's set membership, so memory is O(width) however tall the maze is.
+class EllerStream {
+private:
+    int width;
+    vector<int> label;       // per column: a member column of the same set
+    vector<int> parent;      // union-find over columns of the current row
+    vector<int> remaining;   // per root: members not yet given a downward decision
+    vector<int> firstDown;   // per root: first column that continues downward
+    vector<uint8_t> hasDown, cameFromAbove, goesDown;
+    vector<uint8_t> row;
+
+    int find(int x) {
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    }
+
+public:
+    EllerStream(int _width) : width(_width) {}
+
+    void generate(long long height, Pcg32& rng, MazeRowSink& sink) {
+        label.resize(width);
+        parent.resize(width);
+        remaining.resize(width);
+        firstDown.resize(width);
+        hasDown.resize(width);
+        cameFromAbove.assign(width, 0);
+        goesDown.resize(width);
+        row.resize(width);
+        for (int c = 0; c < width; c++) label[c] = c;
+
+        for (long long y = 0; y < height; y++) {
+            bool lastRow = y == height - 1;
+            for (int c = 0; c < width; c++) {
+                parent[c] = label[c];
+                row[c] = cameFromAbove[c] ? 0xF & ~(1 << TOP) : 0xF;
+            }
+
+            // Join neighbouring sets at random; the last row must join them all
+            for (int c = 0; c + 1 < width; c++) {
+                int a = find(c), b = find(c + 1);
+                if (a == b || (!lastRow && rng.below(2) == 0)) continue;
+                parent[std::max(a, b)] = std::min(a, b);
+                row[c] &= ~(1 << RIGHT);
+                row[c + 1] &= ~(1 << LEFT);
+            }
+
+            if (!lastRow) {
+                for (int c = 0; c < width; c++) {
+                    remaining[c] = 0;
+                    hasDown[c] = 0;
+                    firstDown[c] = -1;
+                }
+                for (int c = 0; c < width; c++) remaining[find(c)]++;
+
+                // Every set continues downward at least once
+                for (int c = 0; c < width; c++) {
+                    int root = find(c);
+                    remaining[root]--;
+                    bool down = rng.below(2) == 0 || (remaining[root] == 0 && !hasDown[root]);
+                    goesDown[c] = down;
+                    if (!down) continue;
+                    hasDown[root] = 1;
+                    if (firstDown[root] < 0) firstDown[root] = c;
+                    row[c] &= ~(1 << BOTTOM);
+                }
+                for (int c = 0; c < width; c++) {
+                    label[c] = goesDown[c] ? firstDown[find(c)] : c;
+                    cameFromAbove[c] = goesDown[c];
+                }
+            }
+
+            sink.consumeRow(y, row.data(), width);
+        }
+    }
+};
+
+// Copies streamed rows into a MazeGrid so the regular renderer can draw them
+class GridRowSink : public MazeRowSink {
+private:
+    MazeGrid& grid;
+
+public:
+    GridRowSink(MazeGrid& _grid) : grid(_grid) {}
+
+    void consumeRow(long long row, const uint8_t* walls, int width) override {
+        int base = static_cast<int>(row) * width;
+        for (int c = 0; c < width; c++) grid.setWallMask(base + c, walls[c]);
+    }
+};
+
+// Writes streamed rows to disk as packed nibbles, two cells per byte
+class FileRowSink : public MazeRowSink {
+private:
+    FILE* file;
+    vector<uint8_t> packed;
+
+public:
+    FileRowSink(FILE* _file) : file(_file) {}
+
+    void consumeRow(long long, const uint8_t* walls, int width) override {
+        packed.assign((width + 1) / 2, 0);
+        for (int c = 0; c < width; c++) packed[c >> 1] |= walls[c] << ((c & 1) << 2);
+        fwrite(packed.data(), 1, packed.size(), file);
+    }
+};
+
+// Eller's algorithm as a regular generator, so it can also drive Maze
+class EllerGenerator : public MazeGenerator {
+public:
+    const char* name() const override { return "eller"; }
+
+    void generate(MazeGrid& grid, Pcg32& rng) override {
+        EllerStream stream(grid.getWidth());
+        GridRowSink sink(grid);
+        stream.generate(grid.getHeight(), rng, sink);
+    }
+};
+
+// Splits the grid into fixed TILE x TILE tiles carved in parallel by the
+// backtracker, then joins them with a random spanning tree of tile-border
+// openings. Each tile is its own spanning tree and the joins form a tree over
+// tiles, so the result is still perfect. Tile layout and seeds do not depend
+// on the thread count, so a seed gives the same maze on every machine.
+class TiledGenerator : public MazeGenerator {
+private:
+    static constexpr int TILE = 128;   // even, so each band of tile rows owns whole wall bytes
+
+    vector<int> joins;
+    vector<int> parent;
+
+    int find(int x) {
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    }
+
+public:
+    const char* name() const override { return "tiled"; }
+
+    void generate(MazeGrid& grid, Pcg32& rng) override {
+        int width = grid.getWidth(), height = grid.getHeight();
+        int tilesX = (width + TILE - 1) / TILE, tilesY = (height + TILE - 1) / TILE;
+        uint64_t baseSeed = rng.next64();
+
+        // One task per band of tile rows; bands never share a byte of the wall grid
+        sharedPool().parallelFor(tilesY, [&](int ty) {
+            BacktrackerGenerator carver;
+            MazeGrid tile;
+            for (int tx = 0; tx < tilesX; tx++) {
+                int x0 = tx * TILE, y0 = ty * TILE;
+                tile.resize(std::min(TILE, width - x0), std::min(TILE, height - y0));
+                Pcg32 tileRng(mixSeed(baseSeed, static_cast<uint64_t>(ty) * tilesX + tx));
+                carver.generate(tile, tileRng);
+                grid.blit(tile, x0, y0);
+            }
+        });
+
+        // Kruskal over tiles: join j links tile j/2 to its right (even) or lower (odd) neighbour
+        joins.clear();
+        for (int t = 0; t < tilesX * tilesY; t++) {
+            if (t % tilesX != tilesX - 1) joins.push_back(t * 2);
+            if (t / tilesX != tilesY - 1) joins.push_back(t * 2 + 1);
+        }
+        for (int i = static_cast<int>(joins.size()) - 1; i > 0; i--) std::swap(joins[i], joins[rng.below(i + 1)]);
+        parent.resize(tilesX * tilesY);
+        for (size_t i = 0; i < parent.size(); i++) parent[i] = static_cast<int>(i);
+
+        for (int join : joins) {
+            int a = join / 2;
+            int b = (join & 1) ? a + tilesX : a + 1;
+            int rootA = find(a), rootB = find(b);
+            if (rootA == rootB) continue;
+            parent[rootA] = rootB;
+
+            int x0 = (a % tilesX) * TILE, y0 = (a / tilesX) * TILE;
+            if (join & 1) {
+                int x = x0 + rng.below(std::min(TILE, width - x0));
+                int pos = (y0 + TILE - 1) * width + x;
+                grid.removeWallBetween(pos, pos + width);
+            }
+            else {
+                int y = y0 + rng.below(std::min(TILE, height - y0));
+                int pos = y * width + x0 + TILE - 1;
+                grid.removeWallBetween(pos, pos + 1);
+            }
+        }
+    }
+};
+
+enum GeneratorId { GEN_BACKTRACKER, GEN_KRUSKAL, GEN_PRIM, GEN_WILSON, GEN_BINARY_TREE, GEN_SIDEWINDER, GEN_ELLER, GEN_TILED, GENERATOR_COUNT };
+
+std::unique_ptr<MazeGenerator> createGenerator(int id) {
+    switch (id) {
+    case GEN_KRUSKAL: return std::make_unique<KruskalGenerator>();
+    case GEN_PRIM: return std::make_unique<PrimGenerator>();
+    case GEN_WILSON: return std::make_unique<WilsonGenerator>();
+    case GEN_BINARY_TREE: return std::make_unique<BinaryTreeGenerator>();
+    case GEN_SIDEWINDER: return std::make_unique<SidewinderGenerator>();
+    case GEN_ELLER: return std::make_unique<EllerGenerator>();
+    case GEN_TILED: return std::make_unique<TiledGenerator>();
+    default: return std::make_unique<BacktrackerGenerator>();
+    }
+}
+
+struct SolveResult {
+    vector<int> path;        // cells from start to goal inclusive; empty if unreachable
+    long long expanded = 0;  // cells taken off the frontier
+
+    bool found() const { return !path.empty(); }
+};
+
+// Shortest-path searches over MazeGrid walls. Frontier, parent and score
+// buffers are kept between calls and reset with a generation stamp, so a
+// query costs nothing proportional to the maze size beyond what it visits.
+class MazeSolver {
+private:
+    vector<uint32_t> seenA, seenB;
+    vector<int> parentA, parentB;
+    vector<int> queueA, queueB;
+    vector<int> cost;
+    vector<uint64_t> heap;
+    uint32_t stamp = 0;
+
+    void prepare(const MazeGrid& grid) {
+        size_t count = grid.cellCount();
+        if (seenA.size() != count) {
+            seenA.assign(count, 0);
+            seenB.assign(count, 0);
+            parentA.resize(count);
+            parentB.resize(count);
+            queueA.resize(count);
+            queueB.resize(count);
+            cost.resize(count);
+            stamp = 0;
+        }
+        if (++stamp == 0) {
+            std::fill(seenA.begin(), seenA.end(), 0);
+            std::fill(seenB.begin(), seenB.end(), 0);
+            stamp = 1;
+        }
+    }
+
+    // Appends start..to by walking parents back from `to`
+    static void tracePath(const vector<int>& parent, int to, vector<int>& path) {
+        size_t first = path.size();
+        for (int pos = to; pos >= 0; pos = parent[pos]) path.push_back(pos);
+        std::reverse(path.begin() + first, path.end());
+    }
+
+public:
+    // Neighbour offsets indexed by Side
+    static void sideOffsets(int width, int offsets[4]) {
+        offsets[TOP] = -width;
+        offsets[RIGHT] = 1;
+        offsets[BOTTOM] = width;
+        offsets[LEFT] = -1;
+    }
+
+    SolveResult bfs(const MazeGrid& grid, int start, int goal) {
+        return withShape(grid.getWidth(), grid.getHeight(), [&](const auto& shape) { return bfsWith(shape, grid, start, goal); });
+    }
+
+    // Plain BFS with the neighbour offsets of a given shape; a goal of -1 floods everything
+    template <typename Shape>
+    SolveResult bfsWith(const Shape& shape, const MazeGrid& grid, int start, int goal) {
+        SolveResult result;
+        prepare(grid);
+
+        int head = 0, tail = 0;
+        seenA[start] = stamp;
+        parentA[start] = -1;
+        queueA[tail++] = start;
+
+        while (head < tail) {
+            int pos = queueA[head++];
+            result.expanded++;
+            if (pos == goal) {
+                tracePath(parentA, goal, result.path);
+                return result;
+            }
+            int mask = grid.wallMask(pos);
+            for (int side = 0; side < 4; side++) {
+                if (mask & (1 << side)) continue;
+                int next = pos + shape.offset(side);
+                if (seenA[next] == stamp) continue;
+                seenA[next] = stamp;
+                parentA[next] = pos;
+                queueA[tail++] = next;
+            }
+        }
+        return result;
+    }
+
+    // Grows one BFS layer at a time from whichever end has the smaller frontier
+    SolveResult bidirectional(const MazeGrid& grid, int start, int goal) {
+        SolveResult result;
+        prepare(grid);
+        int offsets[4];
+        sideOffsets(grid.getWidth(), offsets);
+
+        int headA = 0, tailA = 0, headB = 0, tailB = 0;
+        seenA[start] = stamp;
+        parentA[start] = -1;
+        queueA[tailA++] = start;
+        seenB[goal] = stamp;
+        parentB[goal] = -1;
+        queueB[tailB++] = goal;
+
+        int meet = start == goal ? start : -1;
+        while (meet < 0 && headA < tailA && headB < tailB) {
+            bool forward = tailA - headA <= tailB - headB;
+            vector<uint32_t>& seen = forward ? seenA : seenB;
+            vector<uint32_t>& other = forward ? seenB : seenA;
+            vector<int>& parent = forward ? parentA : parentB;
+            vector<int>& queue = forward ? queueA : queueB;
+            int& head = forward ? headA : headB;
+            int& tail = forward ? tailA : tailB;
+
+            int layerEnd = tail;
+            while (meet < 0 && head < layerEnd) {
+                int pos = queue[head++];
+                result.expanded++;
+                int mask = grid.wallMask(pos);
+                for (int side = 0; side < 4; side++) {
+                    if (mask & (1 << side)) continue;
+                    int next = pos + offsets[side];
+                    if (seen[next] == stamp) continue;
+                    seen[next] = stamp;
+                    parent[next] = pos;
+                    queue[tail++] = next;
+                    if (other[next] == stamp) {
+                        meet = next;
+                        break;
+                    }
+                }
+            }
+        }
+        if (meet < 0) return result;
+
+        tracePath(parentA, meet, result.path);
+        for (int pos = parentB[meet]; pos >= 0; pos = parentB[pos]) result.path.push_back(pos);
+        return result;
+    }
+
+    // A* with the Manhattan distance to the goal as heuristic
+    SolveResult aStar(const MazeGrid& grid, int start, int goal) {
+        SolveResult result;
+        prepare(grid);
+        int width = grid.getWidth();
+        int offsets[4];
+        sideOffsets(width, offsets);
+        int goalX = goal % width, goalY = goal / width;
+        auto estimate = [&](int pos) { return std::abs(pos % width - goalX) + std::abs(pos / width - goalY); };
+
+        // Heap entries pack (f << 32 | cell) so the smallest f pops first
+        heap.clear();
+        seenA[start] = stamp;
+        parentA[start] = -1;
+        cost[start] = 0;
+        heap.push_back((static_cast<uint64_t>(estimate(start)) << 32) | static_cast<uint32_t>(start));
+
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<uint64_t>());
+            int pos = static_cast<int>(heap.back() & 0xFFFFFFFFu);
+            heap.pop_back();
+            if (seenB[pos] == stamp) continue;
+            seenB[pos] = stamp;
+            result.expanded++;
+            if (pos == goal) {
+                tracePath(parentA, goal, result.path);
+                return result;
+            }
+            int mask = grid.wallMask(pos);
+            for (int side = 0; side < 4; side++) {
+                if (mask & (1 << side)) continue;
+                int next = pos + offsets[side];
+                int g = cost[pos] + 1;
+                if (seenA[next] == stamp && cost[next] <= g) continue;
+                seenA[next] = stamp;
+                parentA[next] = pos;
+                cost[next] = g;
+                heap.push_back((static_cast<uint64_t>(g + estimate(next)) << 32) | static_cast<uint32_t>(next));
+                std::push_heap(heap.begin(), heap.end(), std::greater<uint64_t>());
+            }
+        }
+        return result;
+    }
+};
+
+// Guidance towards the goal, computed once per maze. Each cell stores the side
+// to leave through to get one step closer (2 bits) and whether it lies on the
+// start-to-goal path (1 bit), packed one nibble per cell like the walls. In a
+// perfect maze every move changes the distance by exactly one, so the distance
+// remaining is tracked incrementally from the start distance.
+class GoalField {
+private:
+    vector<uint8_t> cells;
+    vector<int> queue;
+    int width = 0;
+    int goal = 0;
+    int startDistance = 0;
+
+    static const int ON_PATH = 4;
+    static const int NO_ROUTE = 0xF;   // not reached from the goal
+
+    int nibble(int pos) const { return (cells[pos >> 1] >> ((pos & 1) << 2)) & 0xF; }
+
+    void setNibble(int pos, int value) {
+        int shift = (pos & 1) << 2;
+        cells[pos >> 1] = static_cast<uint8_t>((cells[pos >> 1] & ~(0xF << shift)) | (value << shift));
+    }
+
+public:
+    void build(const MazeGrid& grid, int start, int _goal) {
+        width = grid.getWidth();
+        goal = _goal;
+        int count = grid.cellCount();
+        int offsets[4];
+        MazeSolver::sideOffsets(width, offsets);
+
+        // BFS outwards from the goal; a newly reached cell points back the way it came
+        cells.assign((count + 1) / 2, static_cast<uint8_t>(NO_ROUTE * 0x11));
+        queue.resize(count);
+        int head = 0, tail = 0;
+        setNibble(goal, 0);
+        queue[tail++] = goal;
+        while (head < tail) {
+            int pos = queue[head++];
+            int mask = grid.wallMask(pos);
+            for (int side = 0; side < 4; side++) {
+                if (mask & (1 << side)) continue;
+                int next = pos + offsets[side];
+                if (nibble(next) != NO_ROUTE) continue;
+                setNibble(next, (side + 2) & 3);
+                queue[tail++] = next;
+            }
+        }
+        queue.clear();
+        queue.shrink_to_fit();
+
+        startDistance = 0;
+        int pos = start;
+        for (; pos != goal && nibble(pos) != NO_ROUTE; pos = nextStep(pos), startDistance++) setNibble(pos, nibble(pos) | ON_PATH);
+        setNibble(goal, ON_PATH);
+    }
+
+    // The neighbouring cell one step closer to the goal, or -1 at the goal and
+    // where no route leads there
+    int nextStep(int pos) const {
+        if (pos == goal || nibble(pos) == NO_ROUTE) return -1;
+        switch (nibble(pos) & 3) {
+        case TOP: return pos - width;
+        case RIGHT: return pos + 1;
+        case BOTTOM: return pos + width;
+        default: return pos - 1;
+        }
+    }
+
+    bool onPath(int pos) const { return nibble(pos) != NO_ROUTE && (nibble(pos) & ON_PATH) != 0; }
+    int getStartDistance() const { return startDistance; }
+
+    // Distance to the goal after stepping from `from` to the adjacent `to`
+    int distanceAfterMove(int from, int to, int distance) const { return nextStep(from) == to ? distance - 1 : distance + 1; }
+};
+
+int popCount64(uint64_t bits) {
+#ifdef _MSC_VER
+    return static_cast<int>(__popcnt64(bits));
+#else
+    return __builtin_popcountll(bits);
+#endif
+}
+
+// Corridor-compressed view of a maze. Nodes are dead ends, branch points and
+// any forced cells (start, goal); every edge is a corridor between two nodes,
+// weighted by its length, with the cells it runs through kept in one shared
+// array. Queries then step over whole corridors instead of single cells.
+class JunctionGraph {
+private:
+    struct Edge {
+        int from, to;
+        int length;                  // steps from `from` to `to`
+        int runStart, runLength;     // interior cells in runCells, ordered from `from`
+    };
+
+    vector<int> nodeCell;            // node -> cell
+    vector<int> nodeIndex;           // cell -> node, or -1 inside a corridor
+    vector<Edge> edges;
+    vector<int> runCells;
+    vector<int> adjacencyStart, adjacency;
+    int deadEnds = 0, branches = 0;
+
+    // Scratch for shortest-path queries
+    vector<int> dist, parentEdge;
+    vector<uint64_t> heap;
+
+public:
+    void build(const MazeGrid& grid, const vector<int>& forced) {
+        int count = grid.cellCount();
+        int offsets[4];
+        MazeSolver::sideOffsets(grid.getWidth(), offsets);
+
+        nodeCell.clear();
+        nodeIndex.assign(count, -1);
+        deadEnds = branches = 0;
+        for (int pos = 0; pos < count; pos++) {
+            int degree = 4 - popCount64(grid.wallMask(pos));
+            if (degree == 1) deadEnds++;
+            if (degree >= 3) branches++;
+            if (degree == 2) continue;
+            nodeIndex[pos] = static_cast<int>(nodeCell.size());
+            nodeCell.push_back(pos);
+        }
+        for (int pos : forced) {
+            if (nodeIndex[pos] >= 0) continue;
+            nodeIndex[pos] = static_cast<int>(nodeCell.size());
+            nodeCell.push_back(pos);
+        }
+
+        // Walk every corridor from both ends, keeping the walk that starts at the lower node
+        edges.clear();
+        runCells.clear();
+        for (int u = 0; u < static_cast<int>(nodeCell.size()); u++) {
+            int mask = grid.wallMask(nodeCell[u]);
+            for (int side = 0; side < 4; side++) {
+                if (mask & (1 << side)) continue;
+                size_t runStart = runCells.size();
+                int prev = nodeCell[u], cur = prev + offsets[side], length = 1, arrival = (side + 2) & 3;
+                while (nodeIndex[cur] < 0) {
+                    runCells.push_back(cur);
+                    int open = grid.wallMask(cur);
+                    for (int t = 0; t < 4; t++) {
+                        if ((open & (1 << t)) || cur + offsets[t] == prev) continue;
+                        prev = cur;
+                        cur += offsets[t];
+                        arrival = (t + 2) & 3;
+                        break;
+                    }
+                    length++;
+                }
+                int v = nodeIndex[cur];
+                if (u < v || (u == v && side < arrival)) {
+                    edges.push_back({ u, v, length, static_cast<int>(runStart), static_cast<int>(runCells.size() - runStart) });
+                }
+                else {
+                    runCells.resize(runStart);
+                }
+            }
+        }
+
+        int nodes = static_cast<int>(nodeCell.size());
+        adjacencyStart.assign(nodes + 1, 0);
+        for (const Edge& edge : edges) {
+            adjacencyStart[edge.from + 1]++;
+            adjacencyStart[edge.to + 1]++;
+        }
+        for (int i = 0; i < nodes; i++) adjacencyStart[i + 1] += adjacencyStart[i];
+        adjacency.resize(adjacencyStart[nodes]);
+        vector<int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+        for (int e = 0; e < static_cast<int>(edges.size()); e++) {
+            adjacency[fill[edges[e].from]++] = e;
+            adjacency[fill[edges[e].to]++] = e;
+        }
+    }
+
+    int nodeCount() const { return static_cast<int>(nodeCell.size()); }
+    int edgeCount() const { return static_cast<int>(edges.size()); }
+    int getDeadEnds() const { return deadEnds; }
+    int getBranches() const { return branches; }
+    int nodeOf(int cell) const { return nodeIndex[cell]; }
+
+    // Cells per node: how much work corridor compression saves
+    double compression() const { return nodeCell.empty() ? 0 : static_cast<double>(nodeIndex.size()) / nodeCell.size(); }
+
+    double averageCorridor() const {
+        long long total = 0;
+        for (const Edge& edge : edges) total += edge.length;
+        return edges.empty() ? 0 : static_cast<double>(total) / edges.size();
+    }
+
+    // Dijkstra over nodes between two node cells (e.g. the forced start and goal).
+    // `expanded` counts nodes, and the returned path is expanded back to cells.
+    SolveResult solve(int startCell, int goalCell) {
+        SolveResult result;
+        int start = nodeIndex[startCell], goal = nodeIndex[goalCell];
+        if (start < 0 || goal < 0) return result;
+
+        dist.assign(nodeCell.size(), INT32_MAX);
+        parentEdge.assign(nodeCell.size(), -1);
+        heap.clear();
+        dist[start] = 0;
+        heap.push_back(static_cast<uint32_t>(start));
+
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<uint64_t>());
+            uint64_t top = heap.back();
+            heap.pop_back();
+            int u = static_cast<int>(top & 0xFFFFFFFFu);
+            if (static_cast<int>(top >> 32) != dist[u]) continue;
+            result.expanded++;
+            if (u == goal) break;
+            for (int i = adjacencyStart[u]; i < adjacencyStart[u + 1]; i++) {
+                const Edge& edge = edges[adjacency[i]];
+                int v = edge.from == u ? edge.to : edge.from;
+                int d = dist[u] + edge.length;
+                if (d >= dist[v]) continue;
+                dist[v] = d;
+                parentEdge[v] = adjacency[i];
+                heap.push_back((static_cast<uint64_t>(d) << 32) | static_cast<uint32_t>(v));
+                std::push_heap(heap.begin(), heap.end(), std::greater<uint64_t>());
+            }
+        }
+        if (dist[goal] == INT32_MAX) return result;
+
+        // Walk back goal -> start, appending each corridor's cells in travel order reversed
+        result.path.push_back(nodeCell[goal]);
+        for (int v = goal; v != start;) {
+            const Edge& edge = edges[parentEdge[v]];
+            bool forward = edge.to == v;
+            for (int i = 0; i < edge.runLength; i++) {
+                result.path.push_back(runCells[edge.runStart + (forward ? edge.runLength - 1 - i : i)]);
+            }
+            v = forward ? edge.from : edge.to;
+            result.path.push_back(nodeCell[v]);
+        }
+        std::reverse(result.path.begin(), result.path.end());
+        return result;
+    }
+
+    // Branch points passed through along a cell path; each is a choice for the player
+    int decisionPoints(const vector<int>& path) const {
+        int decisions = 0;
+        for (size_t i = 0; i + 1 < path.size(); i++) {
+            int node = nodeIndex[path[i]];
+            if (node >= 0 && adjacencyStart[node + 1] - adjacencyStart[node] >= 3) decisions++;
+        }
+        return decisions;
+    }
+};
+
+// Writes one axis-aligned rectangle as a quad starting at vertices[index]
+void setQuad(sf::VertexArray& vertices, size_t index, float x, float y, float w, float h, sf::Color color) {
+    vertices[index + 0] = sf::Vertex({ x, y }, color);
+    vertices[index + 1] = sf::Vertex({ x + w, y }, color);
+    vertices[index + 2] = sf::Vertex({ x + w, y + h }, color);
+    vertices[index + 3] = sf::Vertex({ x, y + h }, color);
+}
+
+void appendQuad(sf::VertexArray& vertices, float x, float y, float w, float h, sf::Color color) {
+    size_t index = vertices.getVertexCount();
+    vertices.resize(index + 4);
+    setQuad(vertices, index, x, y, w, h, color);
+}
+
+// Appends the wall quads of one cell whose top-left corner is at (x, y)
+void appendCellWalls(sf::VertexArray& vertices, int mask, float x, float y) {
+    const sf::Color wallColor(223, 243, 228);
+    const float s = CELL_WIDTH, t = WALL_THICKNESS;
+    if (mask & (1 << TOP)) appendQuad(vertices, x, y, s, t, wallColor);
+    if (mask & (1 << RIGHT)) appendQuad(vertices, x + s, y, t, s, wallColor);
+    if (mask & (1 << BOTTOM)) appendQuad(vertices, x, y + s, s + t, t, wallColor);
+    if (mask & (1 << LEFT)) appendQuad(vertices, x, y, t, s, wallColor);
+}
+
+// How hard a maze is to play from the top-left start to the bottom-right goal
+struct MazeMetrics {
+    uint64_t seed = 0;
+    int pathLength = 0;       // steps on the shortest path
+    int deadEnds = 0;
+    int decisions = 0;        // branch points passed on the shortest path
+    double branching = 0;     // average exits offered at those branch points
+    double difficulty = 0;
+};
+
+// Measures a maze through its junction graph. Difficulty counts the shortest
+// path's steps plus the wrong turns offered along it, each costing a short
+// detour, and a little for dead ends elsewhere.
+MazeMetrics measureMaze(const MazeGrid& grid, JunctionGraph& graph) {
+    MazeMetrics metrics;
+    int goal = grid.cellCount() - 1;
+    graph.build(grid, { 0, goal });
+    SolveResult solved = graph.solve(0, goal);
+    if (solved.path.empty()) return metrics;
+
+    int exits = 0;
+    for (size_t i = 0; i + 1 < solved.path.size(); i++) {
+        int open = 4 - popCount64(grid.wallMask(solved.path[i]));
+        if (open >= 3) exits += open - 1;
+    }
+    metrics.pathLength = static_cast<int>(solved.path.size()) - 1;
+    metrics.deadEnds = graph.getDeadEnds();
+    metrics.decisions = graph.decisionPoints(solved.path);
+    metrics.branching = metrics.decisions ? static_cast<double>(exits) / metrics.decisions : 0;
+    double wrongTurns = exits - metrics.decisions;
+    metrics.difficulty = metrics.pathLength + 4 * wrongTurns + 0.25 * metrics.deadEnds;
+    return metrics;
+}
+
+// Target difficulty as a range of percentiles among sampled candidates, so it
+// holds for any size and generator without tuning absolute numbers
+struct DifficultyBand {
+    double low, high;
+};
+
+DifficultyBand difficultyBandFor(int size) {
+    if (size <= 15) return { 0.15, 0.45 };
+    if (size <= 25) return { 0.40, 0.70 };
+    return { 0.65, 0.95 };
+}
+
+#define CALIBRATION_CANDIDATES 64
+#define CALIBRATION_BUDGET_MS 40
+
+struct CalibrationResult {
+    MazeMetrics chosen;
+    int measured = 0;
+    double milliseconds = 0;
+};
+
+// Generates candidate seeds derived from baseSeed in parallel, measures each
+// and picks the one ranked closest to the middle of the band. Candidates not
+// started within the time budget are skipped, so a slow machine settles for a
+// smaller sample instead of delaying the screen change. The same base seed,
+// size and generator give the same choice whenever the budget is not hit.
+CalibrationResult calibrateMaze(int size, int generatorId, uint64_t baseSeed, DifficultyBand band,
+    int candidates = CALIBRATION_CANDIDATES) {
+    CalibrationResult result;
+    vector<MazeMetrics> metrics(candidates);
+    vector<char> measured(candidates, 0);
+    sf::Clock clock;
+
+    sharedPool().parallelFor(candidates, [&](int i) {
+        if (i > 0 && clock.getElapsedTime().asMilliseconds() >= CALIBRATION_BUDGET_MS) return;
+        MazeGrid grid(size, size);
+        JunctionGraph graph;
+        std::unique_ptr<MazeGenerator> generator = createGenerator(generatorId);
+        uint64_t seed = mixSeed(baseSeed, i);
+        Pcg32 rng(seed);
+        generator->generate(grid, rng);
+        metrics[i] = measureMaze(grid, graph);
+        metrics[i].seed = seed;
+        measured[i] = 1;
+    });
+
+    vector<MazeMetrics> ranked;
+    for (int i = 0; i < candidates; i++) {
+        if (measured[i]) ranked.push_back(metrics[i]);
+    }
+    std::stable_sort(ranked.begin(), ranked.end(), [](const MazeMetrics& a, const MazeMetrics& b) { return a.difficulty < b.difficulty; });
+    double target = (band.low + band.high) / 2 * (ranked.size() - 1);
+    result.chosen = ranked[std::min(ranked.size() - 1, static_cast<size_t>(std::lround(target)))];
+    result.measured = static_cast<int>(ranked.size());
+    result.milliseconds = clock.getElapsedTime().asMicroseconds() / 1000.0;
+    return result;
+}
+
+// A maze generated off the UI thread, with its goal field, ready to be swapped in
+struct PreparedMaze {
+    MazeGrid grid;
+    GoalField goalField;
+    uint64_t seed = 0;
+};
+
+class Maze {
+private:
+    MazeGrid grid;
+    int size;
+
+    std::unique_ptr<MazeGenerator> generator;
+    int generatorId = GEN_BACKTRACKER;
+    uint64_t seed = 0;
+    Pcg32 seedSource;
+
+    // Walls of the visible cells. Rebuilt only when the maze changes or the
+    // camera shows a different range of cells, so the cost depends on the
+    // screen size, not the maze size.
+    sf::VertexArray vertices;
+    bool verticesDirty = true;
+    sf::IntRect cachedRange;
+
+    // The same walls rendered once into a texture, so a frame is one sprite.
+    // Ranges too large for a texture fall back to drawing the vertices.
+    sf::RenderTexture layer;
+    sf::Sprite layerSprite;
+    bool layerReady = false;
+
+    // The red active-cell fill is a dynamic quad drawn over the static layer
+    sf::VertexArray activeQuad{ sf::Quads, 4 };
+    int activePos = -1;
+
+    void buildVertices(const sf::IntRect& range) {
+        verticesDirty = false;
+        cachedRange = range;
+        vertices.clear();
+        vertices.setPrimitiveType(sf::Quads);
+
+        for (int row = range.top; row < range.top + range.height; row++) {
+            for (int col = range.left; col < range.left + range.width; col++) {
+                int pos = row * size + col;
+                sf::Vector2f corner = cellPosition(pos);
+                appendCellWalls(vertices, grid.wallMask(pos), corner.x, corner.y);
+            }
+        }
+    }
+
+    void buildLayer(const sf::IntRect& range) {
+        buildVertices(range);
+        layerReady = false;
+        if (range.width == 0 || range.height == 0) return;
+
+        unsigned width = static_cast<unsigned>(range.width * CELL_WIDTH + WALL_THICKNESS);
+        unsigned height = static_cast<unsigned>(range.height * CELL_WIDTH + WALL_THICKNESS);
+        if (static_cast<unsigned long long>(width) * height > MAX_LAYER_PIXELS) return;
+        if (width > sf::Texture::getMaximumSize() || height > sf::Texture::getMaximumSize()) return;
+
+        // Grow-only, so scrolling around a maze does not reallocate the texture
+        sf::Vector2u current = layer.getSize();
+        if (current.x < width || current.y < height) {
+            unsigned grownWidth = current.x > width ? current.x : width;
+            unsigned grownHeight = current.y > height ? current.y : height;
+            if (!layer.create(grownWidth, grownHeight)) return;
+        }
+
+        sf::Vector2f origin = cellPosition(range.top * size + range.left);
+        sf::Transform shift;
+        shift.translate(-origin.x, -origin.y);
+        layer.setView(layer.getDefaultView());
+        layer.clear(sf::Color::Transparent);
+        layer.draw(vertices, shift);
+        layer.display();
+
+        layerSprite.setTexture(layer.getTexture());
+        layerSprite.setTextureRect(sf::IntRect(0, 0, width, height));
+        layerSprite.setPosition(origin);
+        layerReady = true;
+    }
+
+    // Built on first use after each generateMaze
+    GoalField goalField;
+    bool goalFieldDirty = true;
+    JunctionGraph junctions;
+    bool junctionsDirty = true;
+
+    // While pregeneration is on, the next maze of the seed sequence is built on a
+    // worker thread with its own generator; the buffers of the maze it replaces
+    // are recycled as the spare for the one after
+    bool pregenerate = false;
+    std::unique_ptr<MazeGenerator> pregenerator;
+    std::unique_ptr<PreparedMaze> spare;
+    std::future<std::unique_ptr<PreparedMaze>> upcoming;
+
+    // Calibrated mazes are chosen by measured difficulty among candidates
+    // derived from the next seed of the sequence
+    bool calibrated = false;
+    DifficultyBand band = { 0, 1 };
+
+    void prepareNext() {
+        if (!spare) spare = std::make_unique<PreparedMaze>();
+        if (!pregenerator) pregenerator = createGenerator(generatorId);
+        MazeGenerator* worker = pregenerator.get();
+        int n = size, id = generatorId;
+        bool calibrate = calibrated;
+        DifficultyBand target = band;
+        uint64_t nextSeed = seedSource.next64();
+        upcoming = std::async(std::launch::async, [worker, n, id, calibrate, target, nextSeed](std::unique_ptr<PreparedMaze> prepared) {
+            prepared->seed = calibrate ? calibrateMaze(n, id, nextSeed, target).chosen.seed : nextSeed;
+            prepared->grid.resize(n, n);
+            Pcg32 rng(prepared->seed);
+            worker->generate(prepared->grid, rng);
+            prepared->goalField.build(prepared->grid, 0, n * n - 1);
+            return prepared;
+        }, std::move(spare));
+    }
+
+    // Waits for an in-flight maze and keeps only its buffers
+    void discardPrepared() {
+        if (upcoming.valid()) spare = upcoming.get();
+    }
+
+public:
+    // A calibrated maze picks every maze, the first one included, by measured
+    // difficulty within the size's band
+    Maze(int _size, int _generatorId = GEN_BACKTRACKER, bool _calibrated = false) : grid(_size, _size), size(_size),
+        seedSource(std::random_device{}()), calibrated(_calibrated), band(difficultyBandFor(_size)) {
+        setGenerator(_generatorId);
+        generateMaze();
+    }
+
+    // Generates a fresh maze from the next seed of this maze's seed sequence.
+    // With pregeneration on this is a swap of buffers built in the background.
+    void generateMaze() {
+        if (!upcoming.valid()) {
+            uint64_t nextSeed = seedSource.next64();
+            generateMaze(calibrated ? calibrateMaze(size, generatorId, nextSeed, band).chosen.seed : nextSeed);
+            return;
+        }
+
+        std::unique_ptr<PreparedMaze> prepared = upcoming.get();
+        seed = prepared->seed;
+        std::swap(grid, prepared->grid);
+        std::swap(goalField, prepared->goalField);
+        activePos = -1;
+        verticesDirty = true;
+        goalFieldDirty = false;
+        junctionsDirty = true;
+        spare = std::move(prepared);
+        prepareNext();
+    }
+
+    // Starts or stops building the next maze ahead of time; off by default so
+    // benchmarks and tools measure generation on the calling thread
+    void setPregenerate(bool enabled) {
+        if (enabled == pregenerate) return;
+        pregenerate = enabled;
+        if (enabled) prepareNext();
+        else discardPrepared();
+    }
+
+    // The same seed and generator always reproduce the same maze
+    void generateMaze(uint64_t _seed) {
+        ProfileScope profile(PHASE_GENERATE);
+        seed = _seed;
+        grid.reset();
+        Pcg32 rng(seed);
+        generator->generate(grid, rng);
+        activePos = -1;
+        verticesDirty = true;
+        goalFieldDirty = true;
+        junctionsDirty = true;
+    }
+
+    // Directions and path membership towards the bottom-right goal from the top-left start
+    const GoalField& getGoalField() {
+        if (goalFieldDirty) {
+            goalField.build(grid, 0, size * size - 1);
+            goalFieldDirty = false;
+        }
+        return goalField;
+    }
+
+    // Corridor-compressed graph with the start and goal forced to be nodes
+    JunctionGraph& getJunctionGraph() {
+        if (junctionsDirty) {
+            junctions.build(grid, { 0, size * size - 1 });
+            junctionsDirty = false;
+        }
+        return junctions;
+    }
+
+    // Replaces the maze with a saved one, run in place from the mapped file
+    bool loadFile(const char* path) {
+        MazeGrid loaded;
+        MazeFileHeader header;
+        if (!loadMazeFile(path, loaded, header)) return false;
+        if (loaded.getWidth() != loaded.getHeight()) {
+            cout << path << ": only square mazes can be played" << std::endl;
+            return false;
+        }
+
+        discardPrepared();
+        grid = std::move(loaded);
+        size = grid.getWidth();
+        seed = header.seed;
+        activePos = -1;
+        verticesDirty = true;
+        goalFieldDirty = true;
+        junctionsDirty = true;
+        setGenerator(header.generatorId);
+        return true;
+    }
+
+    bool saveFile(const char* path) const {
+        return saveMazeFile(path, grid, seed, generatorId);
+    }
+
+    void setGenerator(int id) {
+        generatorId = (id >= 0 && id < GENERATOR_COUNT) ? id : GEN_BACKTRACKER;
+        generator = createGenerator(generatorId);
+
+        // A maze already prepared with the old algorithm is thrown away
+        discardPrepared();
+        pregenerator.reset();
+        if (pregenerate) prepareNext();
+    }
+
+    // Changes the side length; the next generateMaze builds at the new size
+    void resize(int newSize) {
+        if (newSize == size) return;
+        discardPrepared();
+        size = newSize;
+        grid.resize(size, size);
+        if (pregenerate) prepareNext();
+    }
+
+    int getGeneratorId() const { return generatorId; }
+    const char* getGeneratorName() const { return generator->name(); }
+    uint64_t getSeed() const { return seed; }
+
+    // Cells whose walls can intersect the view, found from grid coordinates
+    sf::IntRect visibleRange(const sf::View& view) const {
+        sf::Vector2f center = view.getCenter(), half = view.getSize() / 2.f;
+        int col0 = std::max(0, static_cast<int>(std::floor((center.x - half.x - MAZE_ORIGIN) / CELL_WIDTH)) - 1);
+        int row0 = std::max(0, static_cast<int>(std::floor((center.y - half.y - MAZE_ORIGIN) / CELL_WIDTH)) - 1);
+        int col1 = std::min(size, static_cast<int>(std::floor((center.x + half.x - MAZE_ORIGIN) / CELL_WIDTH)) + 1);
+        int row1 = std::min(size, static_cast<int>(std::floor((center.y + half.y - MAZE_ORIGIN) / CELL_WIDTH)) + 1);
+        return sf::IntRect(col0, row0, std::max(0, col1 - col0), std::max(0, row1 - row0));
+    }
+
+    void draw(sf::RenderTarget& target) {
+        sf::IntRect range = visibleRange(target.getView());
+        if (verticesDirty || range != cachedRange) buildLayer(range);
+
+        if (layerReady) {
+            target.draw(layerSprite);
+            renderStats.vertices += 4;
+        }
+        else {
+            target.draw(vertices);
+            renderStats.vertices += vertices.getVertexCount();
+        }
+        renderStats.drawCalls++;
+
+        if (activePos >= 0) {
+            target.draw(activeQuad);
+            renderStats.drawCalls++;
+            renderStats.vertices += 4;
+        }
+    }
+
+    // Moves the red active-cell fill; pass -1 to hide it
+    void setActive(int pos) {
+        activePos = pos;
+        if (pos < 0) return;
+        sf::Vector2f corner = cellPosition(pos);
+        setQuad(activeQuad, 0, corner.x, corner.y, CELL_WIDTH, CELL_WIDTH, sf::Color(247, 23, 53));
+    }
+
+    // Top-left pixel corner of a cell
+    sf::Vector2f cellPosition(int pos) const {
+        return sf::Vector2f(MAZE_ORIGIN + (pos % size) * CELL_WIDTH, MAZE_ORIGIN + (pos / size) * CELL_WIDTH);
+    }
+
+    bool hasWall(int pos, int side) const { return grid.hasWall(pos, side); }
+
+    const MazeGrid& getGrid() const { return grid; }
+
+    int getSize() const { return size; }
+
+    // Pixel width and height of the whole maze including its margin
+    float pixelExtent() const { return MAZE_ORIGIN * 2.f + size * CELL_WIDTH; }
+};
+
+// Player input as the game rules see it, independent of keys or a window
+enum GameCommand { CMD_NONE, CMD_LEFT, CMD_RIGHT, CMD_UP, CMD_DOWN, CMD_FORFEIT, COMMAND_COUNT };
+
+enum GameStatus { STATUS_PLAYING, STATUS_WON, STATUS_LOST };
+
+// The rules of a round without any display: position, distance to the goal,
+// a simulated clock and the win/lose conditions. The Game scene draws one of
+// these; bots and tests drive it directly with commands and time steps.
+class GameCore {
+private:
+    Maze maze;
+    int currentPos = 0;
+    int distanceRemaining = 0;
+    int moves = 0;
+    int bestTime = -1;
+    int countdownSeconds = 0;
+    sf::Time played;
+    uint64_t ticks = 0;
+    GameStatus status = STATUS_PLAYING;
+
+    void resetRound() {
+        currentPos = 0;
+        ticks = 0;
+        distanceRemaining = maze.getGoalField().getStartDistance();
+        moves = 0;
+        countdownSeconds = countdownFor(distanceRemaining);
+        played = sf::Time::Zero;
+        status = STATUS_PLAYING;
+    }
+
+public:
+    GameCore(int mazeSize, int generatorId = GEN_BACKTRACKER, bool calibrated = false) : maze(mazeSize, generatorId, calibrated) {
+        resetRound();
+    }
+
+    // Time allowed for a round: a base plus a second per seven steps of the
+    // shortest path, rounded up to 5 s. Typical calibrated 15/25/35 mazes get
+    // about the 60/90/120 s the levels used to have.
+    static int countdownFor(int pathLength) {
+        int seconds = 45 + (pathLength + 6) / 7;
+        return (seconds + 4) / 5 * 5;
+    }
+
+    // Next maze of the seed sequence
+    void restart() {
+        maze.generateMaze();
+        resetRound();
+    }
+
+    void restart(uint64_t seed) {
+        maze.generateMaze(seed);
+        resetRound();
+    }
+
+    // A specific maze, such as one named by a session log
+    void restart(int size, int generatorId, uint64_t seed) {
+        maze.resize(size);
+        if (generatorId != maze.getGeneratorId()) maze.setGenerator(generatorId);
+        restart(seed);
+    }
+
+    bool loadMaze(const char* path) {
+        if (!maze.loadFile(path)) return false;
+        resetRound();
+        return true;
+    }
+
+    // Applies one command; returns true if it changed the state
+    bool apply(GameCommand command) {
+        if (status != STATUS_PLAYING) return false;
+        if (command == CMD_FORFEIT) {
+            status = STATUS_LOST;
+            return true;
+        }
+
+        static const int sides[COMMAND_COUNT] = { -1, LEFT, RIGHT, TOP, BOTTOM, -1 };
+        int size = maze.getSize(), side = sides[command];
+        if (side < 0) return false;
+        int next = withShape(size, size, [&](const auto& shape) { return stepThrough(shape, maze.getGrid(), currentPos, side); });
+        if (next < 0) return false;
+
+        distanceRemaining = maze.getGoalField().distanceAfterMove(currentPos, next, distanceRemaining);
+        currentPos = next;
+        moves++;
+        if (currentPos == size * size - 1) {
+            status = STATUS_WON;
+            int elapsed = static_cast<int>(played.asSeconds());
+            if (bestTime == -1 || elapsed < bestTime) bestTime = elapsed;
+        }
+        return true;
+    }
+
+    // Advances the round clock by one step; the round is lost once the countdown runs out
+    void advance(sf::Time dt) {
+        if (status != STATUS_PLAYING) return;
+        played += dt;
+        ticks++;
+        if (getRemainingSeconds() < 0) status = STATUS_LOST;
+    }
+
+    Maze& getMaze() { return maze; }
+    const Maze& getMaze() const { return maze; }
+    int getPosition() const { return currentPos; }
+    int getGoal() const { return maze.getSize() * maze.getSize() - 1; }
+    int getDistanceRemaining() const { return distanceRemaining; }
+    int getMoves() const { return moves; }
+    int getBestTime() const { return bestTime; }
+    sf::Time getPlayed() const { return played; }
+    uint64_t getTicks() const { return ticks; }
+    int getSecondsPlayed() const { return static_cast<int>(played.asSeconds()); }
+    int getRemainingSeconds() const { return countdownSeconds - getSecondsPlayed(); }
+    GameStatus getStatus() const { return status; }
+    bool isOnPath() { return maze.getGoalField().onPath(currentPos); }
+};
+
+// Scripted players for headless runs
+enum BotPolicy { BOT_SHORTEST, BOT_WALL_FOLLOWER, BOT_RANDOM, BOT_POLICY_COUNT };
+
+class GameBot {
+private:
+    BotPolicy policy;
+    Pcg32 rng;
+    int heading = RIGHT;
+
+    static GameCommand commandFor(int side) {
+        static const GameCommand commands[4] = { CMD_UP, CMD_RIGHT, CMD_DOWN, CMD_LEFT };
+        return commands[side];
+    }
+
+    static bool open(const GameCore& core, int side) {
+        const Maze& maze = core.getMaze();
+        int pos = core.getPosition(), size = maze.getSize();
+        if (side == TOP && pos < size) return false;
+        if (side == BOTTOM && pos + size >= size * size) return false;
+        return !maze.hasWall(pos, side);
+    }
+
+public:
+    GameBot(BotPolicy _policy, uint64_t seed) : policy(_policy), rng(seed) {}
+
+    static const char* policyName(int policy) {
+        static const char* names[BOT_POLICY_COUNT] = { "shortest", "wall-follower", "random" };
+        return policy >= 0 && policy < BOT_POLICY_COUNT ? names[policy] : "?";
+    }
+
+    void reset() { heading = RIGHT; }
+
+    GameCommand next(GameCore& core) {
+        if (policy == BOT_SHORTEST) {
+            int pos = core.getPosition(), step = core.getMaze().getGoalField().nextStep(pos);
+            int size = core.getMaze().getSize();
+            if (step == pos - 1) return CMD_LEFT;
+            if (step == pos + 1) return CMD_RIGHT;
+            if (step == pos - size) return CMD_UP;
+            if (step == pos + size) return CMD_DOWN;
+            return CMD_NONE;
+        }
+        if (policy == BOT_WALL_FOLLOWER) {
+            // Right hand on the wall: prefer turning right, then straight, left, back
+            for (int turn : { 1, 0, 3, 2 }) {
+                int side = (heading + turn) & 3;
+                if (open(core, side)) {
+                    heading = side;
+                    return commandFor(side);
+                }
+            }
+            return CMD_NONE;
+        }
+        int options[4], count = 0;
+        for (int side = 0; side < 4; side++) {
+            if (open(core, side)) options[count++] = side;
+        }
+        return count ? commandFor(options[rng.below(count)]) : CMD_NONE;
+    }
+};
+
+// Plays bot games with no window on the same fixed 60 Hz clock as the game,
+// the bot spending a budget of moves per tick, and reports outcomes and throughput
+int simulateGames(int games, int size, int policy, double movesPerSecond, uint64_t seed) {
+    if (games <= 0 || size <= 1 || policy < 0 || policy >= BOT_POLICY_COUNT || movesPerSecond <= 0) {
+        cout << "Usage: --simulate <games> [size] [policy 0=shortest 1=wall-follower 2=random] [moves/s] [seed]" << std::endl;
+        return 1;
+    }
+    const sf::Time tick = sf::seconds(1.f / 60);
+    const double movesPerTick = movesPerSecond / 60;
+
+    GameCore core(size);
+    GameBot bot(static_cast<BotPolicy>(policy), seed);
+    long long wins = 0, totalMoves = 0, totalTicks = 0, winSeconds = 0;
+
+    sf::Clock clock;
+    for (int game = 0; game < games; game++) {
+        core.restart(mixSeed(seed, game));
+        bot.reset();
+        double moveBudget = 1;
+        while (core.getStatus() == STATUS_PLAYING) {
+            for (; moveBudget >= 1 && core.getStatus() == STATUS_PLAYING; moveBudget -= 1) core.apply(bot.next(core));
+            moveBudget += movesPerTick;
+            core.advance(tick);
+            totalTicks++;
+        }
+        totalMoves += core.getMoves();
+        if (core.getStatus() == STATUS_WON) {
+            wins++;
+            winSeconds += core.getSecondsPlayed();
+        }
+    }
+    double seconds = std::max(clock.getElapsedTime().asMicroseconds() / 1e6, 1e-9);
+
+    printf("%d games, %dx%d, %s bot at %.1f moves/s\n", games, size, size, GameBot::policyName(policy), movesPerSecond);
+    printf("won %lld (%.1f%%), lost %lld; %.1f moves/game, %.1f s/win\n", wins, 100.0 * wins / games, games - wins,
+        static_cast<double>(totalMoves) / games, wins ? static_cast<double>(winSeconds) / wins : 0.0);
+    printf("%.0f games/s, %.0f ticks/s (%.0fx real time)\n", games / seconds, totalTicks / seconds, totalTicks / 60.0 / seconds);
+    return 0;
+}
+
+#define CHUNK_SIZE 16
+#define CHUNK_CACHE_SLOTS 96
+
+// An endless maze cut into CHUNK_SIZE square chunks. Each chunk is a perfect
+// maze generated on first use from the world seed and its coordinates; every
+// edge between two chunks gets one door, placed by a hash both neighbours
+// derive alike, so the world stays connected and a chunk that was evicted
+// comes back identical. Chunks live in a fixed set of slots and the least
+// recently used one is reused, so memory stays flat however far the player goes.
+class ChunkWorld {
+private:
+    struct Chunk {
+        uint64_t key = 0;
+        uint64_t lastUse = 0;
+        bool used = false;
+        MazeGrid grid;
+    };
+
+    uint64_t worldSeed;
+    std::unique_ptr<MazeGenerator> generator;
+    vector<Chunk> slots;
+    uint64_t useClock = 0;
+    uint64_t generated = 0;
+    int lastSlot = 0;
+
+    static int floorDiv(int value, int divisor) { return value >= 0 ? value / divisor : -((-value - 1) / divisor) - 1; }
+
+    static uint64_t chunkKey(int cx, int cy) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+    }
+
+    // Row of the door between (cx, cy) and its east neighbour, column of the one to the south
+    int eastDoor(int cx, int cy) const { return static_cast<int>(mixSeed(worldSeed ^ 0x9E3779B97F4A7C15ULL, chunkKey(cx, cy)) % CHUNK_SIZE); }
+    int southDoor(int cx, int cy) const { return static_cast<int>(mixSeed(worldSeed ^ 0xC2B2AE3D27D4EB4FULL, chunkKey(cx, cy)) % CHUNK_SIZE); }
+
+    void generate(MazeGrid& grid, int cx, int cy) {
+        grid.reset();
+        Pcg32 rng(mixSeed(worldSeed, chunkKey(cx, cy)));
+        generator->generate(grid, rng);
+
+        const int last = CHUNK_SIZE - 1;
+        grid.clearWall(eastDoor(cx, cy) * CHUNK_SIZE + last, RIGHT);
+        grid.clearWall(eastDoor(cx - 1, cy) * CHUNK_SIZE, LEFT);
+        grid.clearWall(last * CHUNK_SIZE + southDoor(cx, cy), BOTTOM);
+        grid.clearWall(southDoor(cx, cy - 1), TOP);
+        generated++;
+    }
+
+public:
+    ChunkWorld(uint64_t seed, int generatorId = GEN_BACKTRACKER) : worldSeed(seed), generator(createGenerator(generatorId)), slots(CHUNK_CACHE_SLOTS) {
+        for (Chunk& chunk : slots) chunk.grid.resize(CHUNK_SIZE, CHUNK_SIZE);
+    }
+
+    // The chunk at chunk coordinates (cx, cy), generated into the least recently
+    // used slot if it is not resident. The last hit is checked first, as
+    // consecutive lookups almost always land in the same chunk.
+    const MazeGrid& chunk(int cx, int cy) {
+        uint64_t key = chunkKey(cx, cy);
+        useClock++;
+        if (slots[lastSlot].used && slots[lastSlot].key == key) {
+            slots[lastSlot].lastUse = useClock;
+            return slots[lastSlot].grid;
+        }
+
+        int victim = 0;
+        for (int i = 0; i < CHUNK_CACHE_SLOTS; i++) {
+            if (slots[i].used && slots[i].key == key) {
+                slots[i].lastUse = useClock;
+                lastSlot = i;
+                return slots[i].grid;
+            }
+            if (!slots[i].used || (slots[victim].used && slots[i].lastUse < slots[victim].lastUse)) victim = i;
+        }
+
+        Chunk& slot = slots[victim];
+        generate(slot.grid, cx, cy);
+        slot.key = key;
+        slot.used = true;
+        slot.lastUse = useClock;
+        lastSlot = victim;
+        return slot.grid;
+    }
+
+    int wallMask(int x, int y) {
+        int cx = floorDiv(x, CHUNK_SIZE), cy = floorDiv(y, CHUNK_SIZE);
+        return chunk(cx, cy).wallMask((y - cy * CHUNK_SIZE) * CHUNK_SIZE + (x - cx * CHUNK_SIZE));
+    }
+
+    bool hasWall(int x, int y, int side) { return (wallMask(x, y) >> side) & 1; }
+
+    // Makes the chunks around (x, y) resident before the player reaches them
+    void prefetch(int x, int y, int radius = 1) {
+        int cx = floorDiv(x, CHUNK_SIZE), cy = floorDiv(y, CHUNK_SIZE);
+        for (int dy = -radius; dy <= radius; dy++) {
+            for (int dx = -radius; dx <= radius; dx++) chunk(cx + dx, cy + dy);
+        }
+        chunk(cx, cy);
+    }
+
+    int residentChunks() const {
+        int count = 0;
+        for (const Chunk& chunk : slots) count += chunk.used;
+        return count;
+    }
+
+    uint64_t generatedChunks() const { return generated; }
+    uint64_t getSeed() const { return worldSeed; }
+};
+
+// Session logs record what a player did so the same workload can be replayed
+// against any build. After an 8-byte header (magic, version, tick rate) come
+// records: a round start is LOG_ROUND, the maze size as a varint, the generator
+// id byte and the 8-byte seed; a command is its GameCommand byte followed by the
+// ticks since the previous record of the round as a varint; LOG_END and the
+// ticks to the end mark where the session was closed. Integers are little-endian.
+#define SESSION_LOG_MAGIC 0x4C525A4D   // "MZRL"
+#define SESSION_LOG_VERSION 1
+#define SESSION_TICK_RATE 60
+#define LOG_ROUND 0x80
+#define LOG_END 0x81
+
+struct SessionRecord {
+    int kind = LOG_END;   // a GameCommand, LOG_ROUND or LOG_END
+    uint64_t tick = 0;    // round tick at which a command or the end happens
+    int size = 0;
+    int generatorId = 0;
+    uint64_t seed = 0;
+};
+
+// Appends records through stdio's buffer, so recording never allocates per command
+class SessionRecorder {
+private:
+    FILE* file = nullptr;
+    uint64_t lastTick = 0;
+
+    void putFixed(uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++) fputc(static_cast<int>((value >> (8 * i)) & 0xFF), file);
+    }
+
+    void putVarint(uint64_t value) {
+        while (value >= 0x80) {
+            fputc(static_cast<int>(value & 0x7F) | 0x80, file);
+            value >>= 7;
+        }
+        fputc(static_cast<int>(value), file);
+    }
+
+public:
+    ~SessionRecorder() { close(); }
+
+    bool open(const char* path) {
+        close();
+        file = fopen(path, "wb");
+        if (!file) {
+            cout << "Error: could not create session log " << path << std::endl;
+            return false;
+        }
+        putFixed(SESSION_LOG_MAGIC, 4);
+        putFixed(SESSION_LOG_VERSION, 2);
+        putFixed(SESSION_TICK_RATE, 2);
+        return true;
+    }
+
+    void close() {
+        if (file) fclose(file);
+        file = nullptr;
+    }
+
+    void round(int size, int generatorId, uint64_t seed) {
+        if (!file) return;
+        fputc(LOG_ROUND, file);
+        putVarint(static_cast<uint64_t>(size));
+        fputc(generatorId, file);
+        putFixed(seed, 8);
+        lastTick = 0;
+
+        // Earlier rounds survive a crash later in the session
+        fflush(file);
+    }
+
+    void command(uint64_t tick, GameCommand command) {
+        if (!file) return;
+        fputc(command, file);
+        putVarint(tick - lastTick);
+        lastTick = tick;
+    }
+
+    void finish(uint64_t tick) {
+        if (!file) return;
+        fputc(LOG_END, file);
+        putVarint(tick - lastTick);
+        close();
+    }
+};
+
+// Reads a whole session log and hands it out one record at a time. A log
+// cut short ends as if closed at the end of its last round.
+class SessionReplay {
+private:
+    vector<uint8_t> bytes;
+    size_t cursor = 0;
+    SessionRecord upcoming;
+
+    bool getVarint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && cursor < bytes.size(); shift += 7) {
+            uint8_t byte = bytes[cursor++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    void readNext() {
+        uint64_t lastTick = upcoming.kind == LOG_ROUND ? 0 : upcoming.tick;
+        upcoming = SessionRecord();
+        upcoming.tick = UINT64_MAX;
+        if (cursor >= bytes.size()) return;
+
+        int kind = bytes[cursor++];
+        uint64_t value = 0;
+        if (kind == LOG_ROUND) {
+            if (!getVarint(value) || value < 2 || value > 4096 || bytes.size() - cursor < 9) return;
+            upcoming.size = static_cast<int>(value);
+            upcoming.generatorId = bytes[cursor++];
+            for (int i = 0; i < 8; i++) upcoming.seed |= static_cast<uint64_t>(bytes[cursor++]) << (8 * i);
+            upcoming.tick = 0;
+        }
+        else if ((kind > CMD_NONE && kind < COMMAND_COUNT) || kind == LOG_END) {
+            if (!getVarint(value)) return;
+            upcoming.tick = lastTick + value;
+        }
+        else {
+            cout << "Error: unknown record " << kind << " in session log" << std::endl;
+            cursor = bytes.size();
+            return;
+        }
+        upcoming.kind = kind;
+    }
+
+public:
+    bool load(const char* path) {
+        FILE* file = fopen(path, "rb");
+        if (!file) {
+            cout << "Error: could not open session log " << path << std::endl;
+            return false;
+        }
+        uint8_t chunk[4096];
+        size_t count;
+        bytes.clear();
+        while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0) bytes.insert(bytes.end(), chunk, chunk + count);
+        fclose(file);
+
+        uint32_t magic = 0;
+        uint16_t version = 0, tickRate = 0;
+        if (bytes.size() >= 8) {
+            memcpy(&magic, bytes.data(), 4);
+            memcpy(&version, bytes.data() + 4, 2);
+            memcpy(&tickRate, bytes.data() + 6, 2);
+        }
+        if (magic != SESSION_LOG_MAGIC || version != SESSION_LOG_VERSION || tickRate != SESSION_TICK_RATE) {
+            cout << "Error: " << path << " is not a session log of this version" << std::endl;
+            return false;
+        }
+        cursor = 8;
+        upcoming = SessionRecord();
+        readNext();
+        if (upcoming.kind != LOG_ROUND) {
+            cout << "Error: " << path << " contains no rounds" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    const SessionRecord& peek() const { return upcoming; }
+    void pop() { readNext(); }
+
+    // Applies every command logged up to the core's current tick; returns how many
+    int feed(GameCore& core) {
+        int applied = 0;
+        while (upcoming.kind < COMMAND_COUNT && upcoming.tick <= core.getTicks()) {
+            core.apply(static_cast<GameCommand>(upcoming.kind));
+            readNext();
+            applied++;
+        }
+        return applied;
+    }
+
+    // True once the core has reached the tick the session was closed at
+    bool finished(const GameCore& core) const {
+        return upcoming.kind == LOG_END && upcoming.tick <= core.getTicks();
+    }
+
+    // Drops what is left of a round that has already been decided
+    void skipToRound() {
+        while (upcoming.kind < COMMAND_COUNT) readNext();
+    }
+};
+
+// Replays a session log against the game rules alone, at the recorded pace or
+// as fast as possible. Each round's outcome folds into a digest, so two builds
+// given the same log can be checked for identical results as well as speed.
+int replayHeadless(const char* path, bool realtime) {
+    SessionReplay replay;
+    if (!replay.load(path)) return 1;
+    const sf::Time tick = sf::seconds(1.f / SESSION_TICK_RATE);
+    static const char* outcomes[] = { "unfinished", "won", "lost" };
+
+    std::unique_ptr<GameCore> core;
+    int rounds = 0;
+    long long commands = 0;
+    uint64_t totalTicks = 0, digest = 0;
+    sf::Clock clock;
+    while (replay.peek().kind == LOG_ROUND) {
+        const SessionRecord& start = replay.peek();
+        if (!core) core = std::make_unique<GameCore>(start.size, start.generatorId);
+        core->restart(start.size, start.generatorId, start.seed);
+        replay.pop();
+
+        for (;;) {
+            commands += replay.feed(*core);
+            if (core->getStatus() != STATUS_PLAYING || replay.finished(*core)) break;
+            if (realtime) {
+                sf::Time due = sf::microseconds(static_cast<sf::Int64>(totalTicks * 1000000 / SESSION_TICK_RATE)) - clock.getElapsedTime();
+                if (due > sf::Time::Zero) sf::sleep(due);
+            }
+            core->advance(tick);
+            totalTicks++;
+        }
+
+        rounds++;
+        const Maze& maze = core->getMaze();
+        digest = mixSeed(digest ^ maze.getSeed(), (static_cast<uint64_t>(core->getPosition()) << 32) ^
+            (static_cast<uint64_t>(core->getMoves()) << 8) ^ (core->getTicks() << 40) ^ core->getStatus());
+        printf("round %d: %dx%d %s seed %llu, %s after %llu ticks and %d moves\n", rounds, maze.getSize(), maze.getSize(),
+            maze.getGeneratorName(), static_cast<unsigned long long>(maze.getSeed()), outcomes[core->getStatus()],
+            static_cast<unsigned long long>(core->getTicks()), core->getMoves());
+        replay.skipToRound();
+    }
+    double seconds = std::max(clock.getElapsedTime().asMicroseconds() / 1e6, 1e-9);
+
+    printf("%d rounds, %lld commands, %llu ticks in %.3f s (%.0f ticks/s), digest %016llx\n", rounds, commands,
+        static_cast<unsigned long long>(totalTicks), seconds, totalTicks / seconds, static_cast<unsigned long long>(digest));
+    return 0;
+}
+
+// Loads each file once and shares it between screens. A path is read either
+// on first use or ahead of time on a background thread via preload(); later
+// lookups hand out the cached object without touching the disk.
+template <typename Resource>
+class ResourceCache {
+private:
+    std::mutex mutex;
+    std::map<string, std::shared_future<std::shared_ptr<const Resource>>> entries;
+
+    static std::shared_ptr<const Resource> load(const string& path) {
+        auto resource = std::make_shared<Resource>();
+        if (!resource->loadFromFile(path)) cout << "Error loading " << path << std::endl;
+        return resource;
+    }
+
+    std::shared_future<std::shared_ptr<const Resource>> entry(const string& path, std::launch policy) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(path);
+        if (it != entries.end()) return it->second;
+        auto future = std::async(policy, load, path).share();
+        entries.emplace(path, future);
+        return future;
+    }
+
+public:
+    void preload(const string& path) { entry(path, std::launch::async); }
+
+    // Blocks only if the file is still loading; a deferred load runs on the caller
+    std::shared_ptr<const Resource> get(const string& path) { return entry(path, std::launch::deferred).get(); }
+};
+
+struct Resources {
+    ResourceCache<sf::Font> fonts;
+    ResourceCache<sf::Texture> textures;
+
+    void preloadAll() {
+        fonts.preload(FONT_PATH);
+        textures.preload(LOBBY_IMAGE_PATH);
+    }
+};
+
+Resources& resources() {
+    static Resources instance;
+    return instance;
+}
+
+// Fetches the next window event, blocking up to `wait` for one to arrive.
+// SFML 2 has no timed waitEvent, so this sleeps in short slices between polls,
+// which keeps an idle loop near zero CPU while staying responsive to input.
+bool nextEvent(sf::Window& window, sf::Event& event, sf::Time wait) {
+    sf::Clock clock;
+    while (!window.pollEvent(event)) {
+        sf::Time left = wait - clock.getElapsedTime();
+        if (left <= sf::Time::Zero) return false;
+        sf::sleep(std::min(left, sf::milliseconds(4)));
+    }
+    return true;
+}
+
+// Damage tracking for a screen loop: a frame is drawn only while something
+// animates or after input changed it; otherwise the loop blocks for events
+// instead of spinning at the frame limit. Menu animations pause while the
+// window is unfocused.
+class FrameScheduler {
+private:
+    bool dirty = true;
+    bool focused = true;
+
+public:
+    void invalidate() { dirty = true; }
+
+    // Every event may change what is shown; focus changes start or stop animation
+    void observe(const sf::Event& event) {
+        if (event.type == sf::Event::LostFocus) focused = false;
+        if (event.type == sf::Event::GainedFocus) focused = true;
+        dirty = true;
+    }
+
+    bool hasFocus() const { return focused; }
+
+    // How long the event wait may block before the next frame is due
+    sf::Time idleWait(bool animating, sf::Time untilChange) const {
+        return dirty || animating ? sf::Time::Zero : untilChange;
+    }
+
+    bool shouldRender(bool animating) {
+        bool render = dirty || animating;
+        dirty = false;
+        return render;
+    }
+};
+
+// Formats text into a fixed buffer and passes it to SFML through a reused
+// sf::String. Each buffer feeds one sf::Text; both strings are grown to the
+// buffer size on first use, which avoids per-frame string reallocation, and
+// an unchanged string leaves the text's geometry alone. The glyph vertices
+// are not pre-grown and can still reallocate when the visible text grows.
+class TextBuffer {
+private:
+    char chars[192] = {};
+    sf::String string;
+    bool reserved = false;
+
+public:
+    void set(sf::Text& text, const char* format, ...) {
+        if (!reserved) {
+            for (size_t i = 0; i + 1 < sizeof(chars); i++) string += sf::String(' ');
+            text.setString(string);
+            reserved = true;
+        }
+
+        va_list args;
+        va_start(args, format);
+        vsnprintf(chars, sizeof(chars), format, args);
+        va_end(args);
+
+        string.clear();
+        for (const char* c = chars; *c; c++) string += sf::String(static_cast<sf::Uint32>(static_cast<unsigned char>(*c)));
+        text.setString(string);
+    }
+};
+
+// One screen of the game. Scenes never run an event loop of their own: the
+// SceneManager feeds them events, advances them in fixed steps and draws them.
+class Scene {
+public:
+    virtual ~Scene() {}
+
+    virtual void handleEvent(const sf::Event& event) = 0;
+    virtual void update(sf::Time dt) = 0;
+    virtual void draw(sf::RenderWindow& window) = 0;
+
+    // Animated scenes are redrawn every step and freeze while the window is
+    // unfocused; the others redraw only after a change and keep their timers running
+    virtual bool isAnimating() const { return false; }
+
+    // Upper bound on how long the scene can go without a redraw when nothing happens
+    virtual sf::Time untilChange() const { return sf::milliseconds(250); }
+};
+
+// A stack of scenes driven by a single loop. Simulation advances in fixed
+// steps of simulated time, independent of how often frames are drawn, so
+// animation speed and countdowns do not depend on the refresh rate.
+class SceneManager {
+private:
+    struct StackChange {
+        bool pop;
+        std::unique_ptr<Scene> scene;
+    };
+
+    sf::RenderWindow& window;
+    vector<std::unique_ptr<Scene>> stack;
+    vector<StackChange> pending;
+    FrameScheduler frames;
+    sf::Time step;
+    bool lockstep = false;
+
+    // Frames since the last scene change; the first frames of a scene warm up
+    // glyph caches and render textures, so only later ones count as steady state
+    int settledFrames = 0;
+    bool reportAllocations = false;
+
+    // F3 shows live profiler numbers over any scene
+    bool showProfile = false;
+    std::shared_ptr<const sf::Font> font;
+    sf::Text profileText;
+    sf::RectangleShape profileBackground;
+    TextBuffer profileLabel;
+
+    void drawProfile() {
+        // Averages over the rendered frames of the last second (at most the ring)
+        size_t rendered = 0;
+        int64_t busy = 0, worst = 0, phases[PHASE_COUNT] = {};
+        const FrameSample& latest = profiler.recent(0);
+        for (size_t i = 0; i < profiler.frames(); i++) {
+            const FrameSample& sample = profiler.recent(i);
+            if (latest.start - sample.start > 1000000) break;
+            if (!sample.rendered) continue;
+            int64_t work = sample.duration - sample.phaseTime[PHASE_IDLE];
+            busy += work;
+            worst = std::max(worst, work);
+            for (int phase = 0; phase < PHASE_COUNT; phase++) phases[phase] += sample.phaseTime[phase];
+            rendered++;
+        }
+        double frames = static_cast<double>(std::max<size_t>(rendered, 1));
+
+        profileLabel.set(profileText,
+            "%zu fps   busy %.2f ms avg  %.2f ms max\n"
+            "events %.2f  update %.2f  render %.2f  generate %.2f ms\n"
+            "draws %llu  vertices %llu  allocations %llu",
+            rendered, busy / frames / 1000.0, worst / 1000.0,
+            phases[PHASE_EVENTS] / frames / 1000.0, phases[PHASE_UPDATE] / frames / 1000.0,
+            phases[PHASE_RENDER] / frames / 1000.0, phases[PHASE_GENERATE] / frames / 1000.0,
+            static_cast<unsigned long long>(latest.drawCalls), static_cast<unsigned long long>(latest.vertices),
+            static_cast<unsigned long long>(latest.allocations));
+
+        window.setView(window.getDefaultView());
+        window.draw(profileBackground);
+        window.draw(profileText);
+    }
+
+    // Scenes request changes from inside their own callbacks, so they are applied in between
+    void applyChanges() {
+        for (auto& change : pending) {
+            if (!change.pop) stack.push_back(std::move(change.scene));
+            else if (!stack.empty()) stack.pop_back();
+        }
+        if (!pending.empty()) {
+            frames.invalidate();
+            settledFrames = 0;
+        }
+        pending.clear();
+    }
+
+public:
+    SceneManager(sf::RenderWindow& window, sf::Time step = sf::seconds(1.f / 60)) : window(window), step(step) {
+        font = resources().fonts.get(FONT_PATH);
+        profileText.setFont(*font);
+        profileText.setCharacterSize(14);
+        profileText.setFillColor(sf::Color::White);
+        profileText.setPosition(10, window.getSize().y - 70.f);
+        profileBackground.setSize({ 430, 66 });
+        profileBackground.setPosition(4, window.getSize().y - 72.f);
+        profileBackground.setFillColor(sf::Color(0, 0, 0, 170));
+    }
+
+    sf::RenderWindow& getWindow() { return window; }
+
+    void push(std::unique_ptr<Scene> scene) { pending.push_back({ false, std::move(scene) }); }
+    void pop() { pending.push_back({ true, nullptr }); }
+    void replace(std::unique_ptr<Scene> scene) { pop(); push(std::move(scene)); }
+
+    // For changes a scene makes outside of event handling, such as a timer tick
+    void invalidate() { frames.invalidate(); }
+
+    // In lockstep every loop runs exactly one update step and draws one frame
+    // without waiting, so a replay runs as fast as the machine allows and frame
+    // N of a trace is the same simulation tick in every build
+    void setLockstep(bool enabled) { lockstep = enabled; }
+
+    // Names every settled frame that allocated; a quiet console means the
+    // steady-state loop stays off the heap
+    void setAllocationReport(bool enabled) { reportAllocations = enabled; }
+
+    void run() {
+        sf::Clock clock;
+        sf::Time lag;
+        applyChanges();
+
+        while (window.isOpen() && !stack.empty()) {
+            profiler.beginFrame();
+            bool animating = frames.hasFocus() && stack.back()->isAnimating();
+            sf::Time wait = lockstep ? sf::Time::Zero : frames.idleWait(animating, stack.back()->untilChange());
+
+            sf::Event event;
+            while (!stack.empty()) {
+                bool received;
+                {
+                    ProfileScope idle(PHASE_IDLE);
+                    received = nextEvent(window, event, wait);
+                }
+                if (!received) break;
+
+                ProfileScope handling(PHASE_EVENTS);
+                wait = sf::Time::Zero;
+                frames.observe(event);
+                if (event.type == sf::Event::Closed) window.close();
+                else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3) showProfile = !showProfile;
+                else stack.back()->handleEvent(event);
+                applyChanges();
+            }
+            if (!window.isOpen() || stack.empty()) break;
+
+            {
+                // Catch the simulation up with real time; a long stall is dropped
+                // rather than replayed as a burst of steps
+                ProfileScope updating(PHASE_UPDATE);
+                lag += std::min(clock.restart(), sf::seconds(2));
+                if (stack.back()->isAnimating() && !frames.hasFocus()) lag = sf::Time::Zero;
+                if (lockstep) lag = step;
+                while (lag >= step && !stack.empty()) {
+                    stack.back()->update(step);
+                    applyChanges();
+                    lag -= step;
+                }
+            }
+            if (!window.isOpen() || stack.empty()) break;
+
+            bool render = frames.shouldRender(frames.hasFocus() && stack.back()->isAnimating()) || lockstep;
+            if (render) {
+                {
+                    ProfileScope rendering(PHASE_RENDER);
+                    window.clear(sf::Color(13, 2, 33));
+                    stack.back()->draw(window);
+                    if (showProfile && profiler.frames() > 0) drawProfile();
+                }
+
+                // display() also sleeps for the frame limit, so it counts as idle
+                ProfileScope presenting(PHASE_IDLE);
+                window.display();
+            }
+            profiler.endFrame(render);
+
+            const FrameSample& sample = profiler.recent(0);
+            if (reportAllocations && render && settledFrames >= 2 && sample.allocations > 0) {
+                printf("frame %llu: %llu heap allocations\n", static_cast<unsigned long long>(sample.frame),
+                    static_cast<unsigned long long>(sample.allocations));
+            }
+            if (render) settledFrames++;
+        }
+    }
+};
+
+class MazeAnimation {
+private:
+    sf::RectangleShape miniMaze;
+    vector<sf::RectangleShape> walls;
+    sf::CircleShape player;
+    sf::Vector2f position;
+    sf::Vector2f velocity;
+    float rotation;
+    float rotationSpeed;
+
+public:
+
+    MazeAnimation(float x, float y) {
+        position = sf::Vector2f(x, y);
+
+        // Create mini maze
+        miniMaze.setSize(sf::Vector2f(120, 120));
+        miniMaze.setFillColor(sf::Color(20, 20, 40));
+        miniMaze.setOutlineThickness(3);
+        miniMaze.setOutlineColor(sf::Color(100, 100, 200));
+        miniMaze.setOrigin(60, 60);
+
+        // Create some walls inside the mini maze
+        for (int i = 0; i < 6; i++) {
+            sf::RectangleShape wall;
+            wall.setFillColor(sf::Color(223, 243, 228));
+
+            if (i % 2 == 0) {
+                // Horizontal walls
+                wall.setSize(sf::Vector2f(40, 4));
+                wall.setPosition(-20 + (i / 2) * 10, -30 + (i / 2) * 15);
+            }
+            else {
+                // Vertical walls
+                wall.setSize(sf::Vector2f(4, 40));
+                wall.setPosition(-30 + ((i - 1) / 2) * 20, -20 + ((i - 1) / 2) * 15);
+            }
+            walls.push_back(wall);
+        }
+
+        // Create player dot
+        player.setRadius(5);
+        player.setFillColor(sf::Color(247, 23, 53));
+        player.setOrigin(5, 5);
+        player.setPosition(0, 0);
+
+        // Initialize animation properties, per second (the old per-frame values at 60 fps)
+        velocity = sf::Vector2f(60.0f, 90.0f);
+        rotation = 0.0f;
+        rotationSpeed = 12.0f;
+    }
+
+    void update(sf::Time dt) {
+        float seconds = dt.asSeconds();
+
+        // Update position
+        position += velocity * seconds;
+
+        // Bounce off screen edges
+        if (position.x < 200 || position.x > 1080) {
+            velocity.x = -velocity.x;
+        }
+
+        if (position.y < 250 || position.y > 550) {
+            velocity.y = -velocity.y;
+        }
+
+        // Rotate the maze
+        rotation += rotationSpeed * seconds;
+
+        // Move player inside the maze in a circular pattern
+        float playerRadius = 30;
+        float playerX = cos(rotation * 2) * playerRadius;
+        float playerY = sin(rotation * 2) * playerRadius;
+        player.setPosition(playerX, playerY);
+    }
+
+    void draw(sf::RenderWindow& window) {
+        // Save current transform
+        sf::Transform transform;
+        transform.translate(position);
+        transform.rotate(rotation);
+
+        // Draw the maze
+        window.draw(miniMaze, transform);
+
+        // Draw the walls
+        for (auto& wall : walls) {
+            window.draw(wall, transform);
+        }
+
+        // Draw the player
+        window.draw(player, transform);
+    }
+};
+
+class Lobby : public Scene {
+private:
+    SceneManager& scenes;
+    std::function<void()> onStart;
+    std::shared_ptr<const sf::Font> font;
+    sf::Text title;
+    sf::Text startText;
+    sf::Text exitText;
+    sf::RectangleShape startButton;
+    sf::RectangleShape exitButton;
+    std::shared_ptr<const sf::Texture> lobbyimage;
+	sf::Sprite lobbySprite;
+
+    // Hover state tracking
+    bool startHovered;
+    bool exitHovered;
+
+    // Animation
+    MazeAnimation mazeAnimation1;
+    MazeAnimation mazeAnimation2;
+    MazeAnimation mazeAnimation3;
+
+public:
+    Lobby(SceneManager& scenes, std::function<void()> onStart) :
+        scenes(scenes),
+        onStart(onStart),
+        startHovered(false),
+        exitHovered(false),
+        mazeAnimation1(200, 350),
+        mazeAnimation2(scenes.getWindow().getSize().x - 200, 250),
+        mazeAnimation3(scenes.getWindow().getSize().x / 2, 550)
+    {
+        sf::RenderWindow& window = scenes.getWindow();
+        font = resources().fonts.get(FONT_PATH);
+		lobbyimage = resources().textures.get(LOBBY_IMAGE_PATH);
+
+
+        title.setFont(*font);
+        title.setString("Maze Game");
+        title.setCharacterSize(80);
+        title.setFillColor(sf::Color::Yellow);
+        title.setPosition(window.getSize().x / 2 - title.getGlobalBounds().width / 2, 100);
+
+        // Start button setup
+        startText.setFont(*font);
+        startText.setString("Press Enter to Start");
+        startText.setCharacterSize(30);
+        startText.setFillColor(sf::Color::White);
+
+        // Exit button setup
+        exitText.setFont(*font);
+        exitText.setString("Press Escape to Exit");
+        exitText.setCharacterSize(30);
+        exitText.setFillColor(sf::Color::White);
+
+        // Create button rectangles
+        const float padding = 20.0f;
+        startButton.setSize({ startText.getGlobalBounds().width + padding * 2, startText.getGlobalBounds().height + padding * 2 });
+        startButton.setFillColor(sf::Color(50, 50, 100));
+        startButton.setOutlineThickness(2);
+        startButton.setOutlineColor(sf::Color(100, 100, 200));
+
+        exitButton.setSize({ exitText.getGlobalBounds().width + padding * 2, exitText.getGlobalBounds().height + padding * 2 });
+        exitButton.setFillColor(sf::Color(100, 50, 50));
+        exitButton.setOutlineThickness(2);
+        exitButton.setOutlineColor(sf::Color(200, 100, 100));
+
+        // Position the buttons
+        startButton.setPosition(window.getSize().x / 2 - startButton.getSize().x / 2, 300);
+        exitButton.setPosition(window.getSize().x / 2 - exitButton.getSize().x / 2, 400);
+
+        // Position the text in the middle of the buttons
+        startText.setPosition(
+            startButton.getPosition().x + (startButton.getSize().x - startText.getGlobalBounds().width) / 2,
+            startButton.getPosition().y + (startButton.getSize().y - startText.getGlobalBounds().height) / 2 - 15
+        );
+
+        exitText.setPosition(
+            exitButton.getPosition().x + (exitButton.getSize().x - exitText.getGlobalBounds().width) / 2,
+            exitButton.getPosition().y + (exitButton.getSize().y - exitText.getGlobalBounds().height) / 2 - 15
+        );
+    }
+
+    bool isAnimating() const override { return true; }
+
+    void update(sf::Time dt) override {
+        // Update animations
+        mazeAnimation1.update(dt);
+        mazeAnimation2.update(dt);
+        mazeAnimation3.update(dt);
+    }
+
+    void handleEvent(const sf::Event& event) override {
+        sf::RenderWindow& window = scenes.getWindow();
+        if (event.type == sf::Event::KeyPressed) {
+            if (event.key.code == sf::Keyboard::Enter) onStart();
+            else if (event.key.code == sf::Keyboard::Escape) window.close();
+        }
+
+        // Handle mouse movement for hover effects
+        if (event.type == sf::Event::MouseMoved) {
+            sf::Vector2f mousePos(event.mouseMove.x, event.mouseMove.y);
+            startHovered = startButton.getGlobalBounds().contains(mousePos);
+            exitHovered = exitButton.getGlobalBounds().contains(mousePos);
+        }
+
+        // Handle mouse clicks on buttons
+        if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+            sf::Vector2f mousePos(event.mouseButton.x, event.mouseButton.y);
+            if (startButton.getGlobalBounds().contains(mousePos)) onStart();
+            if (exitButton.getGlobalBounds().contains(mousePos)) window.close();
+        }
+
+        // Update button colors based on hover status
+        startButton.setFillColor(startHovered ? sf::Color(80, 80, 180) : sf::Color(50, 50, 100));
+        exitButton.setFillColor(exitHovered ? sf::Color(180, 80, 80) : sf::Color(100, 50, 50));
+    }
+
+    void draw(sf::RenderWindow& window) override {
+        // Draw animated mazes
+        mazeAnimation1.draw(window);
+        mazeAnimation2.draw(window);
+        mazeAnimation3.draw(window);
+
+        window.draw(title);
+        window.draw(startButton);
+        window.draw(exitButton);
+        window.draw(startText);
+        window.draw(exitText);
+		window.draw(lobbySprite);
+    }
+};
+class LevelSelector : public Scene {
+private:
+    SceneManager& scenes;
+    std::function<void(int)> onSelect;
+    std::shared_ptr<const sf::Font> font;
+    sf::Text title, easyText, mediumText, hardText, endlessText;
+    sf::RectangleShape easyButton, mediumButton, hardButton, endlessButton;
+    bool easyHovered, mediumHovered, hardHovered, endlessHovered;
+    MazeAnimation mazeAnimation1;
+    MazeAnimation mazeAnimation2;
+    MazeAnimation mazeAnimation3;
+
+public:
+    // onSelect receives the maze size of the chosen level, or 0 for endless mode
+    LevelSelector(SceneManager& scenes, std::function<void(int)> onSelect) : scenes(scenes), onSelect(onSelect),
+        easyHovered(false), mediumHovered(false), hardHovered(false), endlessHovered(false), mazeAnimation1(200, 350),
+        mazeAnimation2(scenes.getWindow().getSize().x - 200, 250),
+        mazeAnimation3(scenes.getWindow().getSize().x / 2, 550) {
+        sf::RenderWindow& window = scenes.getWindow();
+        font = resources().fonts.get(FONT_PATH);
+
+        title.setFont(*font);
+        title.setString("Select Difficulty");
+        title.setCharacterSize(70);
+        title.setFillColor(sf::Color::Yellow);
+        title.setPosition(window.getSize().x / 2 - title.getGlobalBounds().width / 2, 100);
+
+        // Setup text and buttons
+        setupOption(easyText, easyButton, "EASY LEVEL", 200, sf::Color(0, 100, 0));
+        setupOption(mediumText, mediumButton, "MEDIUM LEVEL", 290, sf::Color(100, 100, 0));
+        setupOption(hardText, hardButton, "HARD LEVEL", 380, sf::Color(100, 0, 0));
+        setupOption(endlessText, endlessButton, "ENDLESS", 470, sf::Color(60, 0, 100));
+    }
+
+    void setupOption(sf::Text& text, sf::RectangleShape& button, const std::string& str, float y, sf::Color baseColor) {
+        // Set up text
+        text.setFont(*font);
+        text.setString(str);
+        text.setCharacterSize(30);
+        text.setFillColor(sf::Color::White);
+
+        // Create button with padding
+        const float padding = 20.0f;
+        text.setPosition(0, 0); // Temporary position to get bounds
+        sf::FloatRect textBounds = text.getGlobalBounds();
+
+        button.setSize({textBounds.width + padding * 2, textBounds.height + padding * 2});
+        button.setFillColor(baseColor);
+        button.setOutlineThickness(2);
+        button.setOutlineColor(sf::Color(baseColor.r + 50, baseColor.g + 50, baseColor.b + 50));
+        button.setPosition(scenes.getWindow().getSize().x / 2 - button.getSize().x / 2, y);
+
+        // Position text in the middle of button
+        text.setPosition(
+            button.getPosition().x + (button.getSize().x - textBounds.width) / 2,
+            button.getPosition().y + (button.getSize().y - textBounds.height) / 2 - 15
+        );
+    }
+
+    bool isAnimating() const override { return true; }
+
+    void handleEvent(const sf::Event& event) override {
+        // Check for mouse hovering over buttons
+        if (event.type == sf::Event::MouseMoved) {
+            sf::Vector2f mousePos(event.mouseMove.x, event.mouseMove.y);
+            easyHovered = easyButton.getGlobalBounds().contains(mousePos);
+            mediumHovered = mediumButton.getGlobalBounds().contains(mousePos);
+            hardHovered = hardButton.getGlobalBounds().contains(mousePos);
+            endlessHovered = endlessButton.getGlobalBounds().contains(mousePos);
+
+            // Update button colors based on hover state
+            easyButton.setFillColor(easyHovered ? sf::Color(0, 150, 0) : sf::Color(0, 100, 0));
+            mediumButton.setFillColor(mediumHovered ? sf::Color(150, 150, 0) : sf::Color(100, 100, 0));
+            hardButton.setFillColor(hardHovered ? sf::Color(150, 0, 0) : sf::Color(100, 0, 0));
+            endlessButton.setFillColor(endlessHovered ? sf::Color(100, 0, 150) : sf::Color(60, 0, 100));
+        }
+
+        if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+            sf::Vector2f mousePos(event.mouseButton.x, event.mouseButton.y);
+            if (easyButton.getGlobalBounds().contains(mousePos)) onSelect(15);
+            else if (mediumButton.getGlobalBounds().contains(mousePos)) onSelect(25);
+            else if (hardButton.getGlobalBounds().contains(mousePos)) onSelect(35);
+            else if (endlessButton.getGlobalBounds().contains(mousePos)) onSelect(0);
+        }
+    }
+
+    void update(sf::Time dt) override {
+        mazeAnimation1.update(dt);
+        mazeAnimation2.update(dt);
+        mazeAnimation3.update(dt);
+    }
+
+    void draw(sf::RenderWindow& window) override {
+        mazeAnimation1.draw(window);
+        mazeAnimation2.draw(window);
+        mazeAnimation3.draw(window);
+
+
+        window.draw(title);
+        window.draw(easyButton);
+        window.draw(mediumButton);
+        window.draw(hardButton);
+        window.draw(endlessButton);
+        window.draw(easyText);
+        window.draw(mediumText);
+        window.draw(hardText);
+        window.draw(endlessText);
+    }
+};
+class GameOverScreen : public Scene {
+private:
+    SceneManager& scenes;
+    std::function<void(int)> onChoice;
+    std::shared_ptr<const sf::Font> font;
+    sf::Text title, playAgainText, exitText;
+    sf::RectangleShape playAgainButton, exitButton;
+    bool playAgainHovered, exitHovered;
+    MazeAnimation mazeAnimation1;
     MazeAnimation mazeAnimation2;
     MazeAnimation mazeAnimation3;
 
 public:
-    LevelSelector(sf::RenderWindow& window) : window(window), easyHovered(false), mediumHovered(false), hardHovered(false), mazeAnimation1(200, 350),
-        mazeAnimation2(window.getSize().x - 200, 250),
-        mazeAnimation3(window.getSize().x / 2, 550) {
-        font.loadFromFile("Data/Roboto.ttf");
+    // onChoice receives 1 for Play Again and -1 for Exit
+    GameOverScreen(SceneManager& scenes, std::function<void(int)> onChoice) : scenes(scenes), onChoice(onChoice),
+        playAgainHovered(false), exitHovered(false), mazeAnimation1(200, 350),
+        mazeAnimation2(scenes.getWindow().getSize().x - 200, 250),
+        mazeAnimation3(scenes.getWindow().getSize().x / 2, 550) {
+        sf::RenderWindow& window = scenes.getWindow();
+        font = resources().fonts.get(FONT_PATH);
+
+        title.setFont(*font);
+        title.setString("Game Over");
+        title.setCharacterSize(60);
+        title.setFillColor(sf::Color::Red);
+        title.setPosition(window.getSize().x / 2 - title.getGlobalBounds().width / 2, 100);
+
+        setupOption(playAgainText, playAgainButton, "Play Again", 200, sf::Color(0, 100, 0));
+        setupOption(exitText, exitButton, "Exit", 280, sf::Color(100, 50, 50));
+    }
+
+    void setupOption(sf::Text& text, sf::RectangleShape& button, const std::string& str, float y, sf::Color baseColor) {
+        // Set up text
+        text.setFont(*font);
+        text.setString(str);
+        text.setCharacterSize(30);
+        text.setFillColor(sf::Color::White);
+
+        // Create button with padding
+        const float padding = 20.0f;
+        text.setPosition(0, 0); // Temporary position to get bounds
+        sf::FloatRect textBounds = text.getGlobalBounds();
+
+        button.setSize({textBounds.width + padding * 2, textBounds.height + padding * 2});
+        button.setFillColor(baseColor);
+        button.setOutlineThickness(2);
+        button.setOutlineColor(sf::Color(baseColor.r + 50, baseColor.g + 50, baseColor.b + 50));
+        button.setPosition(scenes.getWindow().getSize().x / 2 - button.getSize().x / 2, y);
+
+        // Position text in the middle of button
+        text.setPosition(
+            button.getPosition().x + (button.getSize().x - textBounds.width) / 2,
+            button.getPosition().y + (button.getSize().y - textBounds.height) / 2 - 15
+        );
+    }
+
+    bool isAnimating() const override { return true; }
+
+    void handleEvent(const sf::Event& event) override {
+        // Check for mouse hovering over buttons
+        if (event.type == sf::Event::MouseMoved) {
+            sf::Vector2f mousePos(event.mouseMove.x, event.mouseMove.y);
+            playAgainHovered = playAgainButton.getGlobalBounds().contains(mousePos);
+            exitHovered = exitButton.getGlobalBounds().contains(mousePos);
+
+            // Update button colors based on hover state
+            playAgainButton.setFillColor(playAgainHovered ? sf::Color(0, 150, 0) : sf::Color(0, 100, 0));
+            exitButton.setFillColor(exitHovered ? sf::Color(150, 50, 50) : sf::Color(100, 50, 50));
+        }
+
+        if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+            sf::Vector2f mousePos(event.mouseButton.x, event.mouseButton.y);
+            if (playAgainButton.getGlobalBounds().contains(mousePos)) onChoice(1);   // Play Again
+            else if (exitButton.getGlobalBounds().contains(mousePos)) onChoice(-1);  // Exit
+        }
+    }
+
+    void update(sf::Time dt) override {
+        mazeAnimation1.update(dt);
+        mazeAnimation2.update(dt);
+        mazeAnimation3.update(dt);
+    }
+
+    void draw(sf::RenderWindow& window) override {
+        mazeAnimation1.draw(window);
+        mazeAnimation2.draw(window);
+        mazeAnimation3.draw(window);
+        window.draw(title);
+        window.draw(playAgainButton);
+        window.draw(exitButton);
+        window.draw(playAgainText);
+        window.draw(exitText);
+    }
+};
+
+
+class CongratulationsScreen : public Scene {
+private:
+    SceneManager& scenes;
+    std::function<void(int)> onChoice;
+    std::shared_ptr<const sf::Font> font;
+    sf::Text title, playAgainText, exitText;
+    sf::RectangleShape playAgainButton, exitButton;
+    bool playAgainHovered, exitHovered;
+    MazeAnimation maze1, maze2, maze3;
+
+public:
+    // onChoice receives 1 for Play Again and -1 for Exit
+    CongratulationsScreen(SceneManager& scenes, std::function<void(int)> onChoice) : scenes(scenes), onChoice(onChoice),
+        playAgainHovered(false), exitHovered(false), maze1(200, 350),
+        maze2(scenes.getWindow().getSize().x - 200, 250),
+        maze3(scenes.getWindow().getSize().x / 2, 550) {
+        sf::RenderWindow& window = scenes.getWindow();
+        font = resources().fonts.get(FONT_PATH);
+
+        title.setFont(*font);
+        title.setString("Congratulations!");
+        title.setCharacterSize(60);
+        title.setFillColor(sf::Color::Green);
+        title.setPosition(window.getSize().x / 2 - title.getGlobalBounds().width / 2, 100);
+
+        setupOption(playAgainText, playAgainButton, "Play Again", 200, sf::Color(0, 100, 0));
+        setupOption(exitText, exitButton, "Exit", 280, sf::Color(100, 50, 50));
+    }
+
+    void setupOption(sf::Text& text, sf::RectangleShape& button, const std::string& str, float y, sf::Color baseColor) {
+        // Set up text
+        text.setFont(*font);
+        text.setString(str);
+        text.setCharacterSize(30);
+        text.setFillColor(sf::Color::White);
+
+        // Create button with padding
+        const float padding = 20.0f;
+        text.setPosition(0, 0); // Temporary position to get bounds
+        sf::FloatRect textBounds = text.getGlobalBounds();
+
+        button.setSize({textBounds.width + padding * 2, textBounds.height + padding * 2});
+        button.setFillColor(baseColor);
+        button.setOutlineThickness(2);
+        button.setOutlineColor(sf::Color(baseColor.r + 50, baseColor.g + 50, baseColor.b + 50));
+        button.setPosition(scenes.getWindow().getSize().x / 2 - button.getSize().x / 2, y);
+
+        // Position text in the middle of button
+        text.setPosition(
+            button.getPosition().x + (button.getSize().x - textBounds.width) / 2,
+            button.getPosition().y + (button.getSize().y - textBounds.height) / 2 - 15
+        );
+    }
+
+    bool isAnimating() const override { return true; }
+
+    void handleEvent(const sf::Event& event) override {
+        // Check for mouse hovering over buttons
+        if (event.type == sf::Event::MouseMoved) {
+            sf::Vector2f mousePos(event.mouseMove.x, event.mouseMove.y);
+            playAgainHovered = playAgainButton.getGlobalBounds().contains(mousePos);
+            exitHovered = exitButton.getGlobalBounds().contains(mousePos);
+
+            // Update button colors based on hover state
+            playAgainButton.setFillColor(playAgainHovered ? sf::Color(0, 150, 0) : sf::Color(0, 100, 0));
+            exitButton.setFillColor(exitHovered ? sf::Color(150, 50, 50) : sf::Color(100, 50, 50));
+        }
+
+        if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+            sf::Vector2f mousePos(event.mouseButton.x, event.mouseButton.y);
+            if (playAgainButton.getGlobalBounds().contains(mousePos)) onChoice(1);   // Play Again
+            else if (exitButton.getGlobalBounds().contains(mousePos)) onChoice(-1);  // Exit
+        }
+    }
+
+    void update(sf::Time dt) override {
+        maze1.update(dt);
+        maze2.update(dt);
+        maze3.update(dt);
+    }
+
+    void draw(sf::RenderWindow& window) override {
+        maze1.draw(window);
+        maze2.draw(window);
+        maze3.draw(window);
+        window.draw(title);
+        window.draw(playAgainButton);
+        window.draw(exitButton);
+        window.draw(playAgainText);
+        window.draw(exitText);
+    }
+};
+
+
+class Game : public Scene {
+private:
+    std::shared_ptr<const sf::Font> font;
+    sf::Text timerText, bestTimeText, countdownText, distanceText, gameOverText;
+
+    SceneManager& scenes;
+    sf::RenderWindow& window;
+
+    // Rules and state of the round; this scene only maps keys to commands and draws
+    GameCore core;
+    bool roundOver = false;
+    bool showHint = false;
+
+    sf::RectangleShape currentHighlight, goalHighlight, hintHighlight;
+
+    // Follows the player when the maze is larger than the window
+    sf::View camera;
+    float zoom = 1.f;
+
+    // Nothing in the game animates, so frames follow input and the HUD clock
+    int shownSecond = -1;
+
+    // HUD labels are reformatted only when the value they show changes
+    TextBuffer timerLabel, bestTimeLabel, countdownLabel, distanceLabel;
+    int hudSecond = -1, hudBest = -2, hudDistance = -1, hudOnPath = -1;
+
+    // Session logging: commands either go to a recorder or come from a replay
+    SessionRecorder* recorder;
+    SessionReplay* replay;
+
+public:
+    Game(SceneManager& scenes, int mazeSize, SessionRecorder* recorder = nullptr, SessionReplay* replay = nullptr)
+        : scenes(scenes), window(scenes.getWindow()), core(mazeSize, GEN_BACKTRACKER, replay == nullptr),
+        recorder(recorder), replay(replay) {
+        font = resources().fonts.get(FONT_PATH);
+
+        // Mazes are picked by measured difficulty for the level, and the next
+        // round's is built while this one is played; a replay names its mazes,
+        // so nothing is picked or prepared ahead
+        if (replay) nextReplayRound();
+        else core.getMaze().setPregenerate(true);
+        recordRound();
+
+
+        setupText(timerText, 30, 5, sf::Color::White);
+        setupText(bestTimeText, 150, 5, sf::Color::Yellow);
+        setupText(countdownText, 300, 5, sf::Color::Red);
+        setupText(distanceText, 480, 5, sf::Color(166, 207, 213));
+
+        gameOverText.setFont(*font);
+        gameOverText.setString("Game Over");
+        gameOverText.setCharacterSize(60);
+        gameOverText.setFillColor(sf::Color::Red);
+        gameOverText.setStyle(sf::Text::Bold);
+        gameOverText.setPosition(200, 200);
+
+        currentHighlight.setSize({ CELL_WIDTH, CELL_WIDTH });
+        currentHighlight.setFillColor(sf::Color(166, 207, 213));
+
+        goalHighlight.setSize({ CELL_WIDTH, CELL_WIDTH });
+        goalHighlight.setFillColor(sf::Color(0, 128, 0));
+
+        hintHighlight.setSize({ CELL_WIDTH, CELL_WIDTH });
+        hintHighlight.setFillColor(sf::Color(255, 215, 0, 140));
+    }
+
+    void setupText(sf::Text& text, float x, float y, sf::Color color) {
+        text.setFont(*font);
+        text.setCharacterSize(20);
+        text.setFillColor(color);
+        text.setPosition(x, y);
+    }
+
+    ~Game() {
+        if (recorder) recorder->finish(core.getTicks());
+    }
+
+    // Idle until input or the next change of the displayed second
+    sf::Time untilChange() const override {
+        return sf::microseconds(1000000 - core.getPlayed().asMicroseconds() % 1000000);
+    }
+
+    // A replay steps every tick so logged commands show up when they happen
+    bool isAnimating() const override { return replay != nullptr; }
+
+    void handleEvent(const sf::Event& event) override {
+        if (event.type == sf::Event::KeyPressed && !roundOver) handleKey(event.key.code);
+        if (event.type == sf::Event::MouseWheelScrolled) zoomCamera(event.mouseWheelScroll.delta > 0 ? 0.9f : 1.1f);
+    }
+
+    void update(sf::Time dt) override {
+        if (roundOver) return;
+        if (replay) {
+            if (replay->feed(core) > 0) scenes.invalidate();
+            if (replay->finished(core)) {
+                window.close();
+                return;
+            }
+        }
+        core.advance(dt);
+
+        int seconds = core.getSecondsPlayed();
+        if (seconds != shownSecond) {
+            shownSecond = seconds;
+            scenes.invalidate();
+        }
+        if (core.getStatus() != STATUS_PLAYING) endRound();
+    }
+
+    void refreshHud() {
+        int seconds = core.getSecondsPlayed();
+        if (seconds != hudSecond) {
+            hudSecond = seconds;
+            int remaining = core.getRemainingSeconds();
+            timerLabel.set(timerText, "Time: %ds", seconds);
+            if (remaining >= 0) countdownLabel.set(countdownText, "Countdown: %ds", remaining);
+            else countdownLabel.set(countdownText, "Time's up!");
+        }
+        if (core.getBestTime() != hudBest) {
+            hudBest = core.getBestTime();
+            if (hudBest != -1) bestTimeLabel.set(bestTimeText, "Best: %ds", hudBest);
+            else bestTimeLabel.set(bestTimeText, "Best: --");
+        }
+        if (core.getDistanceRemaining() != hudDistance) {
+            hudDistance = core.getDistanceRemaining();
+            distanceLabel.set(distanceText, "Steps left: %d", hudDistance);
+        }
+        int onPath = core.isOnPath() ? 1 : 0;
+        if (onPath != hudOnPath) {
+            hudOnPath = onPath;
+            distanceText.setFillColor(onPath ? sf::Color(166, 207, 213) : sf::Color(255, 140, 0));
+        }
+    }
+
+    void draw(sf::RenderWindow& window) override {
+        Maze& maze = core.getMaze();
+        int currentPos = core.getPosition();
+        refreshHud();
+        updateCamera();
+        window.setView(camera);
+        maze.setActive(currentPos);
+        maze.draw(window);
+
+        currentHighlight.setPosition(maze.cellPosition(currentPos));
+        window.draw(currentHighlight);
+
+        goalHighlight.setPosition(maze.cellPosition(core.getGoal()));
+        window.draw(goalHighlight);
+
+        int hint = maze.getGoalField().nextStep(currentPos);
+        if (showHint && hint >= 0) {
+            hintHighlight.setPosition(maze.cellPosition(hint));
+            window.draw(hintHighlight);
+        }
+
+        window.setView(window.getDefaultView());
+        window.draw(timerText);
+        window.draw(bestTimeText);
+        window.draw(countdownText);
+        window.draw(distanceText);
+        if (core.getStatus() == STATUS_LOST) window.draw(gameOverText);
+    }
+
+    static GameCommand commandFor(sf::Keyboard::Key key) {
+        if (key == sf::Keyboard::Left || key == sf::Keyboard::H) return CMD_LEFT;
+        if (key == sf::Keyboard::Right || key == sf::Keyboard::L) return CMD_RIGHT;
+        if (key == sf::Keyboard::Up || key == sf::Keyboard::K) return CMD_UP;
+        if (key == sf::Keyboard::Down || key == sf::Keyboard::J) return CMD_DOWN;
+        if (key == sf::Keyboard::Escape) return CMD_FORFEIT;
+        return CMD_NONE;
+    }
+
+private:
+    void zoomCamera(float factor) {
+        zoom = std::max(0.25f, std::min(8.f, zoom * factor));
+    }
+
+    // Keeps the player centred, clamped to the maze; axes where the whole maze
+    // fits stay anchored top-left as in the unscrolled layout
+    void updateCamera() {
+        const Maze& maze = core.getMaze();
+        sf::Vector2f viewSize(window.getSize().x * zoom, window.getSize().y * zoom);
+        sf::Vector2f player = maze.cellPosition(core.getPosition()) + sf::Vector2f(CELL_WIDTH / 2.f, CELL_WIDTH / 2.f);
+        float extent = maze.pixelExtent();
+
+        sf::Vector2f center;
+        center.x = extent <= viewSize.x ? viewSize.x / 2 : std::max(viewSize.x / 2, std::min(extent - viewSize.x / 2, player.x));
+        center.y = extent <= viewSize.y ? viewSize.y / 2 : std::max(viewSize.y / 2, std::min(extent - viewSize.y / 2, player.y));
+        camera.setSize(viewSize);
+        camera.setCenter(center);
+    }
+
+    void handleKey(sf::Keyboard::Key key) {
+        GameCommand command = commandFor(key);
+        if (command != CMD_NONE && !replay) {
+            if (recorder) recorder->command(core.getTicks(), command);
+            core.apply(command);
+            if (core.getStatus() != STATUS_PLAYING) endRound();
+        }
+
+        // Space toggles the next-best-move hint; +/- zoom the camera
+        if (key == sf::Keyboard::Space) showHint = !showHint;
+        if (key == sf::Keyboard::Equal || key == sf::Keyboard::Add) zoomCamera(0.9f);
+        if (key == sf::Keyboard::Hyphen || key == sf::Keyboard::Subtract) zoomCamera(1.1f);
+
+        // F5 saves the current maze; F9 restarts the round on the saved one
+        if (key == sf::Keyboard::F5) core.getMaze().saveFile(QUICKSAVE_PATH);
+        if (key == sf::Keyboard::F9 && !replay && core.loadMaze(QUICKSAVE_PATH)) {
+            recordRound();
+            resetView();
+        }
+    }
+
+    // Covers the game with the outcome screen; the game resumes underneath on Play Again.
+    // A replay goes straight on to its next round instead.
+    void endRound() {
+        if (replay) {
+            nextReplayRound();
+            return;
+        }
+        roundOver = true;
+        auto onChoice = [this](int result) {
+            scenes.pop();
+            if (result == 1) restartGame(); // Play Again
+            else window.close(); // Exit
+        };
+        if (core.getStatus() == STATUS_WON) scenes.push(std::make_unique<CongratulationsScreen>(scenes, onChoice));
+        else scenes.push(std::make_unique<GameOverScreen>(scenes, onChoice));
+    }
+
+    void restartGame() {
+        core.restart();
+        recordRound();
+        resetView();
+    }
+
+    // A saved maze is logged by its seed and generator, which rebuild it exactly
+    void recordRound() {
+        const Maze& maze = core.getMaze();
+        if (recorder) recorder->round(maze.getSize(), maze.getGeneratorId(), maze.getSeed());
+    }
+
+    // Starts the next logged round, or closes the window once the log runs out
+    void nextReplayRound() {
+        replay->skipToRound();
+        const SessionRecord& start = replay->peek();
+        if (start.kind != LOG_ROUND) {
+            window.close();
+            return;
+        }
+        core.restart(start.size, start.generatorId, start.seed);
+        replay->pop();
+        resetView();
+    }
+
+    void resetView() {
+        roundOver = false;
+        shownSecond = -1;
+        hudSecond = -1;
+        hudDistance = -1;
+        hudOnPath = -1;
+        scenes.invalidate();
+    }
+};
+
+// Endless mode: free roaming through a ChunkWorld with no goal or countdown;
+// the HUD tracks how far from the start the player has got
+class EndlessGame : public Scene {
+private:
+    std::shared_ptr<const sf::Font> font;
+    sf::Text statsText;
+
+    SceneManager& scenes;
+    sf::RenderWindow& window;
+
+    ChunkWorld world;
+    int playerX = 0, playerY = 0;
+    int moves = 0, farthest = 0;
+
+    // Walls of the visible cells, placed relative to the player so vertex
+    // coordinates stay small however far out the player is
+    sf::VertexArray vertices;
+    bool verticesDirty = true;
+    sf::RectangleShape playerHighlight;
+    sf::View camera;
+    float zoom = 1.f;
+
+    TextBuffer statsLabel;
+
+    static uint64_t randomSeed() {
+        std::random_device device;
+        return (static_cast<uint64_t>(device()) << 32) | device();
+    }
+
+public:
+    EndlessGame(SceneManager& scenes) : scenes(scenes), window(scenes.getWindow()), world(randomSeed()) {
+        font = resources().fonts.get(FONT_PATH);
+        statsText.setFont(*font);
+        statsText.setCharacterSize(20);
+        statsText.setFillColor(sf::Color(166, 207, 213));
+        statsText.setPosition(30, 5);
 
-        title.setFont(font);
-        title.setString("Select Difficulty");
-        title.setCharacterSize(70);
-        title.setFillColor(sf::Color::Yellow);
-        title.setPosition(window.getSize().x / 2 - title.getGlobalBounds().width / 2, 100);
+        vertices.setPrimitiveType(sf::Quads);
+        playerHighlight.setSize({ CELL_WIDTH, CELL_WIDTH });
+        playerHighlight.setFillColor(sf::Color(247, 23, 53));
+        world.prefetch(playerX, playerY);
+    }
 
-        // Setup text and buttons
-        setupOption(easyText, easyButton, "EASY LEVEL", 200, sf::Color(0, 100, 0));
-        setupOption(mediumText, mediumButton, "MEDIUM LEVEL", 290, sf::Color(100, 100, 0));
-        setupOption(hardText, hardButton, "HARD LEVEL", 380, sf::Color(100, 0, 0));
+    void handleEvent(const sf::Event& event) override {
+        if (event.type == sf::Event::KeyPressed) {
+            GameCommand command = Game::commandFor(event.key.code);
+            if (command == CMD_FORFEIT) window.close();
+            else if (command != CMD_NONE) move(command);
+
+            if (event.key.code == sf::Keyboard::Equal || event.key.code == sf::Keyboard::Add) zoomCamera(0.9f);
+            if (event.key.code == sf::Keyboard::Hyphen || event.key.code == sf::Keyboard::Subtract) zoomCamera(1.1f);
+        }
+        if (event.type == sf::Event::MouseWheelScrolled) zoomCamera(event.mouseWheelScroll.delta > 0 ? 0.9f : 1.1f);
     }
 
-    void setupOption(sf::Text& text, sf::RectangleShape& button, const std::string& str, float y, sf::Color baseColor) {
-        // Set up text
-        text.setFont(font);
-        text.setString(str);
-        text.setCharacterSize(30);
-        text.setFillColor(sf::Color::White);
-        
-        // Create button with padding
-        const float padding = 20.0f;
-        text.setPosition(0, 0); // Temporary position to get bounds
-        sf::FloatRect textBounds = text.getGlobalBounds();
-        
-        button.setSize({textBounds.width + padding * 2, textBounds.height + padding * 2});
-        button.setFillColor(baseColor);
-        button.setOutlineThickness(2);
-        button.setOutlineColor(sf::Color(baseColor.r + 50, baseColor.g + 50, baseColor.b + 50));
-        button.setPosition(window.getSize().x / 2 - button.getSize().x / 2, y);
-        
-        // Position text in the middle of button
-        text.setPosition(
-            button.getPosition().x + (button.getSize().x - textBounds.width) / 2,
-            button.getPosition().y + (button.getSize().y - textBounds.height) / 2 - 15
-        );
+    void update(sf::Time) override {}
+
+    void draw(sf::RenderWindow& window) override {
+        sf::Vector2f viewSize(window.getSize().x * zoom, window.getSize().y * zoom);
+        if (verticesDirty) rebuild(viewSize);
+        camera.setSize(viewSize);
+        camera.setCenter(CELL_WIDTH / 2.f, CELL_WIDTH / 2.f);
+        window.setView(camera);
+        window.draw(vertices);
+        window.draw(playerHighlight);
+        renderStats.drawCalls += 2;
+        renderStats.vertices += vertices.getVertexCount() + 4;
+
+        statsLabel.set(statsText, "Position: %d, %d   Moves: %d   Farthest: %d   Chunks: %d cached, %llu generated",
+            playerX, playerY, moves, farthest, world.residentChunks(), static_cast<unsigned long long>(world.generatedChunks()));
+        window.setView(window.getDefaultView());
+        window.draw(statsText);
     }
 
-    int run() {
-        while (window.isOpen()) {
-            sf::Event event;
-            while (window.pollEvent(event)) {
-                if (event.type == sf::Event::Closed)
-                    window.close();
-
-                // Check for mouse hovering over buttons
-                if (event.type == sf::Event::MouseMoved) {
-                    sf::Vector2f mousePos(event.mouseMove.x, event.mouseMove.y);
-                    easyHovered = easyButton.getGlobalBounds().contains(mousePos);
-                    mediumHovered = mediumButton.getGlobalBounds().contains(mousePos);
-                    hardHovered = hardButton.getGlobalBounds().contains(mousePos);
-                    
-                    // Update button colors based on hover state
-                    easyButton.setFillColor(easyHovered ? sf::Color(0, 150, 0) : sf::Color(0, 100, 0));
-                    mediumButton.setFillColor(mediumHovered ? sf::Color(150, 150, 0) : sf::Color(100, 100, 0));
-                    hardButton.setFillColor(hardHovered ? sf::Color(150, 0, 0) : sf::Color(100, 0, 0));
-                }
+private:
+    void move(GameCommand command) {
+        static const int sides[COMMAND_COUNT] = { -1, LEFT, RIGHT, TOP, BOTTOM, -1 };
+        static const int stepX[COMMAND_COUNT] = { 0, -1, 1, 0, 0, 0 };
+        static const int stepY[COMMAND_COUNT] = { 0, 0, 0, -1, 1, 0 };
+        if (sides[command] < 0 || world.hasWall(playerX, playerY, sides[command])) return;
 
-                if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
-                    sf::Vector2f mousePos(event.mouseButton.x, event.mouseButton.y);
-                    if (easyButton.getGlobalBounds().contains(mousePos)) return 15;
-                    if (mediumButton.getGlobalBounds().contains(mousePos)) return 25;
-                    if (hardButton.getGlobalBounds().contains(mousePos)) return 35;
-                }
+        playerX += stepX[command];
+        playerY += stepY[command];
+        moves++;
+        farthest = std::max(farthest, std::abs(playerX) + std::abs(playerY));
+        world.prefetch(playerX, playerY);
+        verticesDirty = true;
+    }
+
+    void zoomCamera(float factor) {
+        // Zoomed out far enough, the view would need more chunks than the cache holds
+        zoom = std::max(0.5f, std::min(2.f, zoom * factor));
+        verticesDirty = true;
+    }
+
+    void rebuild(sf::Vector2f viewSize) {
+        int spanX = static_cast<int>(viewSize.x / 2 / CELL_WIDTH) + 2;
+        int spanY = static_cast<int>(viewSize.y / 2 / CELL_WIDTH) + 2;
+        vertices.clear();
+        for (int y = playerY - spanY; y <= playerY + spanY; y++) {
+            for (int x = playerX - spanX; x <= playerX + spanX; x++) {
+                appendCellWalls(vertices, world.wallMask(x, y), static_cast<float>((x - playerX) * CELL_WIDTH),
+                    static_cast<float>((y - playerY) * CELL_WIDTH));
             }
-            mazeAnimation1.update();
-            mazeAnimation2.update();
-            mazeAnimation3.update();
-
-            window.clear(sf::Color(13, 2, 33));
-            mazeAnimation1.draw(window);
-            mazeAnimation2.draw(window);
-            mazeAnimation3.draw(window);
-
-            
-            window.draw(title);
-            window.draw(easyButton);
-            window.draw(mediumButton);
-            window.draw(hardButton);
-            window.draw(easyText);
-            window.draw(mediumText);
-            window.draw(hardText);
-            window.display();
         }
-        return 0;
+        verticesDirty = false;
     }
 };
-class GameOverScreen {
+
+// Headless benchmark: generation throughput and offscreen rendering cost
+class Benchmark {
 private:
-    sf::RenderWindow& window;
-    sf::Font font;
-    sf::Text title, playAgainText, exitText;
-    sf::RectangleShape playAgainButton, exitButton;
-    bool playAgainHovered, exitHovered;
-    MazeAnimation mazeAnimation1;
-    MazeAnimation mazeAnimation2;
-    MazeAnimation mazeAnimation3;
+    int maxSize;
 
-public:
-    GameOverScreen(sf::RenderWindow& window) : window(window), playAgainHovered(false), exitHovered(false), mazeAnimation1(200, 350),
-        mazeAnimation2(window.getSize().x - 200, 250),
-        mazeAnimation3(window.getSize().x / 2, 550) {
-        font.loadFromFile("Data/Roboto.ttf");
+    void benchmarkGeneration(int size, int generatorId) {
+        Maze maze(size, generatorId);
+        long long cells = static_cast<long long>(size) * size;
+        int runs = static_cast<int>(std::max(1LL, std::min(50LL, 4000000LL / cells)));
 
-        title.setFont(font);
-        title.setString("Game Over");
-        title.setCharacterSize(60);
-        title.setFillColor(sf::Color::Red);
-        title.setPosition(window.getSize().x / 2 - title.getGlobalBounds().width / 2, 100);
+        // Fixed seeds keep every run comparable; the hash of seed 1 proves reproducibility
+        uint64_t allocsBefore = allocationCount.load();
+        sf::Clock clock;
+        for (int i = 0; i < runs; i++) maze.generateMaze(i + 1);
+        double seconds = clock.getElapsedTime().asMicroseconds() / 1e6;
+        uint64_t allocs = allocationCount.load() - allocsBefore;
+        maze.generateMaze(1);
 
-        setupOption(playAgainText, playAgainButton, "Play Again", 200, sf::Color(0, 100, 0));
-        setupOption(exitText, exitButton, "Exit", 280, sf::Color(100, 50, 50));
+        printf("%-6d %-12s %14.0f %12.3f %12llu %12.1f %12.1f  %016llx\n", size, maze.getGeneratorName(),
+            cells * runs / seconds, seconds * 1000 / runs,
+            static_cast<unsigned long long>(allocs / runs),
+            maze.getGrid().memoryBytes() / 1048576.0, peakMemoryBytes() / 1048576.0,
+            static_cast<unsigned long long>(maze.getGrid().hash()));
     }
 
-    void setupOption(sf::Text& text, sf::RectangleShape& button, const std::string& str, float y, sf::Color baseColor) {
-        // Set up text
-        text.setFont(font);
-        text.setString(str);
-        text.setCharacterSize(30);
-        text.setFillColor(sf::Color::White);
-        
-        // Create button with padding
-        const float padding = 20.0f;
-        text.setPosition(0, 0); // Temporary position to get bounds
-        sf::FloatRect textBounds = text.getGlobalBounds();
-        
-        button.setSize({textBounds.width + padding * 2, textBounds.height + padding * 2});
-        button.setFillColor(baseColor);
-        button.setOutlineThickness(2);
-        button.setOutlineColor(sf::Color(baseColor.r + 50, baseColor.g + 50, baseColor.b + 50));
-        button.setPosition(window.getSize().x / 2 - button.getSize().x / 2, y);
-        
-        // Position text in the middle of button
-        text.setPosition(
-            button.getPosition().x + (button.getSize().x - textBounds.width) / 2,
-            button.getPosition().y + (button.getSize().y - textBounds.height) / 2 - 15
-        );
+    void benchmarkSolving(MazeSolver& solver, int size) {
+        Maze maze(size);
+        maze.generateMaze(1);
+        const MazeGrid& grid = maze.getGrid();
+        int goal = size * size - 1;
+        const char* names[3] = { "bfs", "bidirectional", "astar" };
+
+        for (int method = 0; method < 3; method++) {
+            sf::Clock clock;
+            SolveResult result = method == 0 ? solver.bfs(grid, 0, goal)
+                : method == 1 ? solver.bidirectional(grid, 0, goal)
+                : solver.aStar(grid, 0, goal);
+            double ms = clock.getElapsedTime().asMicroseconds() / 1000.0;
+            printf("%-6d %-14s %12.3f %14lld %12zu %14.0f\n", size, names[method], ms, result.expanded,
+                result.path.size(), result.expanded / std::max(ms / 1000.0, 1e-9));
+        }
     }
 
-    int run() {
-        while (window.isOpen()) {
-            sf::Event event;
-            while (window.pollEvent(event)) {
-                if (event.type == sf::Event::Closed) window.close();
-                
-                // Check for mouse hovering over buttons
-                if (event.type == sf::Event::MouseMoved) {
-                    sf::Vector2f mousePos(event.mouseMove.x, event.mouseMove.y);
-                    playAgainHovered = playAgainButton.getGlobalBounds().contains(mousePos);
-                    exitHovered = exitButton.getGlobalBounds().contains(mousePos);
-                    
-                    // Update button colors based on hover state
-                    playAgainButton.setFillColor(playAgainHovered ? sf::Color(0, 150, 0) : sf::Color(0, 100, 0));
-                    exitButton.setFillColor(exitHovered ? sf::Color(150, 50, 50) : sf::Color(100, 50, 50));
-                }
-                
-                if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
-                    sf::Vector2f mousePos(event.mouseButton.x, event.mouseButton.y);
-                    if (playAgainButton.getGlobalBounds().contains(mousePos)) return 1;  // Play Again
-                    if (exitButton.getGlobalBounds().contains(mousePos)) return -1;      // Exit
-                }
-            }
-            mazeAnimation1.update();
-            mazeAnimation2.update();
-            mazeAnimation3.update();
+    void benchmarkJunctions(MazeSolver& solver, int size) {
+        Maze maze(size);
+        maze.generateMaze(1);
+        int goal = size * size - 1;
 
+        sf::Clock clock;
+        JunctionGraph& graph = maze.getJunctionGraph();
+        double buildMs = clock.getElapsedTime().asMicroseconds() / 1000.0;
 
+        solver.bfs(maze.getGrid(), 0, goal);
+        clock.restart();
+        SolveResult cells = solver.bfs(maze.getGrid(), 0, goal);
+        double bfsMs = clock.getElapsedTime().asMicroseconds() / 1000.0;
 
-            window.clear(sf::Color(13, 2, 33));
-           
-            mazeAnimation1.draw(window);
-            mazeAnimation2.draw(window);
-            mazeAnimation3.draw(window);
-            window.draw(title);
-            window.draw(playAgainButton);
-            window.draw(exitButton);
-            window.draw(playAgainText);
-            window.draw(exitText);
-            window.display();
-        }
-        return 0;
+        graph.solve(0, goal);
+        clock.restart();
+        SolveResult nodes = graph.solve(0, goal);
+        double graphMs = clock.getElapsedTime().asMicroseconds() / 1000.0;
+
+        printf("%-6d %10.3f %10d %10d %8.2f %8.2f %10d %10.3f %10.3f %12lld %12lld\n", size, buildMs, graph.nodeCount(),
+            graph.edgeCount(), graph.compression(), graph.averageCorridor(), graph.getDeadEnds(), bfsMs, graphMs,
+            cells.expanded, nodes.expanded);
+        if (cells.path != nodes.path) printf("       junction path differs from BFS path!\n");
     }
-};
 
+    // Times one kernel through the runtime fallback and through a preset's
+    // compile-time shape; `run` returns a checksum that must match for both
+    template <typename Shape, typename Kernel>
+    void compareKernel(const Shape& fixed, const char* kernel, int runs, Kernel&& run) {
+        RuntimeShape generic(fixed.width, fixed.height);
+        sf::Clock clock;
+        uint64_t genericSum = run(generic, runs);
+        double genericUs = clock.getElapsedTime().asMicroseconds() / static_cast<double>(runs);
+        clock.restart();
+        uint64_t fixedSum = run(fixed, runs);
+        double fixedUs = clock.getElapsedTime().asMicroseconds() / static_cast<double>(runs);
 
-class CongratulationsScreen {
-private:
-    sf::RenderWindow& window;
-    sf::Font font;
-    sf::Text title, playAgainText, exitText;
-    sf::RectangleShape playAgainButton, exitButton;
-    bool playAgainHovered, exitHovered;
-    MazeAnimation maze1, maze2, maze3;
+        printf("%-6d %-10s %12.3f %12.3f %9.2fx %8s\n", fixed.width, kernel, genericUs, fixedUs,
+            genericUs / std::max(fixedUs, 1e-9), genericSum == fixedSum ? "yes" : "NO");
+    }
 
-public:
-    CongratulationsScreen(sf::RenderWindow& window) : window(window), playAgainHovered(false),  maze1(200, 350),
-        maze2(window.getSize().x - 200, 250),
-        maze3(window.getSize().x / 2, 550) {
-        font.loadFromFile("Data/Roboto.ttf");
+    template <typename Shape>
+    void benchmarkKernels(const Shape& fixed) {
+        BacktrackerGenerator generator;
+        MazeSolver solver;
+        MazeGrid grid(fixed.width, fixed.height);
 
-        title.setFont(font);
-        title.setString("Congratulations!");
-        title.setCharacterSize(60);
-        title.setFillColor(sf::Color::Green);
-        title.setPosition(window.getSize().x / 2 - title.getGlobalBounds().width / 2, 100);
+        compareKernel(fixed, "generate", 2000, [&](const auto& shape, int runs) {
+            uint64_t sum = 0;
+            for (int i = 0; i < runs; i++) {
+                grid.reset();
+                Pcg32 rng(i + 1);
+                generator.carve(shape, grid, rng);
+                sum += grid.hash();
+            }
+            return sum;
+        });
 
-        setupOption(playAgainText, playAgainButton, "Play Again", 200, sf::Color(0, 100, 0));
-        setupOption(exitText, exitButton, "Exit", 280, sf::Color(100, 50, 50));
+        // The maze of the last generation run stays in the grid for the next two
+        compareKernel(fixed, "solve", 2000, [&](const auto& shape, int runs) {
+            uint64_t sum = 0;
+            for (int i = 0; i < runs; i++) sum += solver.bfsWith(shape, grid, 0, shape.count - 1).expanded;
+            return sum;
+        });
+
+        // A random walk; each run is 1000 attempted moves
+        compareKernel(fixed, "move x1000", 200, [&](const auto& shape, int runs) {
+            Pcg32 rng(7);
+            uint64_t pos = 0;
+            for (int i = 0; i < runs * 1000; i++) {
+                int next = stepThrough(shape, grid, static_cast<int>(pos), static_cast<int>(rng.below(4)));
+                if (next >= 0) pos = next;
+            }
+            return pos;
+        });
     }
 
-    void setupOption(sf::Text& text, sf::RectangleShape& button, const std::string& str, float y, sf::Color baseColor) {
-        // Set up text
-        text.setFont(font);
-        text.setString(str);
-        text.setCharacterSize(30);
-        text.setFillColor(sf::Color::White);
-        
-        // Create button with padding
-        const float padding = 20.0f;
-        text.setPosition(0, 0); // Temporary position to get bounds
-        sf::FloatRect textBounds = text.getGlobalBounds();
-        
-        button.setSize({textBounds.width + padding * 2, textBounds.height + padding * 2});
-        button.setFillColor(baseColor);
-        button.setOutlineThickness(2);
-        button.setOutlineColor(sf::Color(baseColor.r + 50, baseColor.g + 50, baseColor.b + 50));
-        button.setPosition(window.getSize().x / 2 - button.getSize().x / 2, y);
-        
-        // Position text in the middle of button
-        text.setPosition(
-            button.getPosition().x + (button.getSize().x - textBounds.width) / 2,
-            button.getPosition().y + (button.getSize().y - textBounds.height) / 2 - 15
-        );
+    void benchmarkRendering(sf::RenderTexture& target, int size) {
+        const int frames = 100;
+        Maze maze(size);
+        maze.setActive(0);
+
+        // First draw builds the vertex cache; time it separately from steady-state frames
+        sf::Clock clock;
+        maze.draw(target);
+        double buildMs = clock.getElapsedTime().asMicroseconds() / 1000.0;
+
+        renderStats.reset();
+        clock.restart();
+        for (int i = 0; i < frames; i++) {
+            target.clear(sf::Color(13, 2, 33));
+            maze.draw(target);
+            target.display();
+        }
+        double frameMs = clock.getElapsedTime().asMicroseconds() / 1000.0 / frames;
+
+        printf("%-6d %12.3f %12.3f %12llu %12llu\n", size, buildMs, frameMs,
+            static_cast<unsigned long long>(renderStats.drawCalls / frames),
+            static_cast<unsigned long long>(renderStats.vertices / frames));
     }
 
+public:
+    Benchmark(int _maxSize) : maxSize(_maxSize) {}
+
     int run() {
-        while (window.isOpen()) {
-            sf::Event event;
-            while (window.pollEvent(event)) {
-                if (event.type == sf::Event::Closed) window.close();
-                
-                // Check for mouse hovering over buttons
-                if (event.type == sf::Event::MouseMoved) {
-                    sf::Vector2f mousePos(event.mouseMove.x, event.mouseMove.y);
-                    playAgainHovered = playAgainButton.getGlobalBounds().contains(mousePos);
-                    exitHovered = exitButton.getGlobalBounds().contains(mousePos);
-                    
-                    // Update button colors based on hover state
-                    playAgainButton.setFillColor(playAgainHovered ? sf::Color(0, 150, 0) : sf::Color(0, 100, 0));
-                    exitButton.setFillColor(exitHovered ? sf::Color(150, 50, 50) : sf::Color(100, 50, 50));
-                }
-                
-                if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
-                    sf::Vector2f mousePos(event.mouseButton.x, event.mouseButton.y);
-                    if (playAgainButton.getGlobalBounds().contains(mousePos)) return 1;  // Play Again
-                    if (exitButton.getGlobalBounds().contains(mousePos)) return -1;      // Exit
-                }
-            }
-            maze1.update();
-            maze2.update();
-            maze3.update();
-
-            window.clear(sf::Color(13, 2, 33));
-            maze1.draw(window);
-            maze2.draw(window);
-            maze3.draw(window);
-            window.draw(title);
-            window.draw(playAgainButton);
-            window.draw(exitButton);
-            window.draw(playAgainText);
-            window.draw(exitText);
-            window.display();
+        const int sizes[] = { 15, 25, 35, 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+
+        printf("Worker threads: %d\n\nGeneration\n%-6s %-12s %14s %12s %12s %12s %12s  %s\n", sharedPool().size(),
+            "size", "generator", "cells/s", "ms/maze", "allocs/maze", "grid MB", "peak RSS MB", "seed 1 hash");
+#ifndef COUNT_ALLOCATIONS
+        printf("(allocs/maze reads 0 without COUNT_ALLOCATIONS)\n");
+#endif
+        for (int size : sizes) {
+            if (size > maxSize) continue;
+            for (int id = 0; id < GENERATOR_COUNT; id++) benchmarkGeneration(size, id);
+        }
+
+        printf("\nPreset kernels, backtracker (us per run, runtime shape vs compile-time shape)\n%-6s %-10s %12s %12s %10s %8s\n",
+            "size", "kernel", "generic us", "fixed us", "speedup", "match");
+        benchmarkKernels(FixedShape<15>());
+        benchmarkKernels(FixedShape<25>());
+        benchmarkKernels(FixedShape<35>());
+
+        MazeSolver solver;
+        printf("\nSolving (corner to corner, seed 1)\n%-6s %-14s %12s %14s %12s %14s\n", "size", "solver", "ms", "expanded", "path cells", "cells/s");
+        for (int size : sizes) {
+            if (size <= maxSize) benchmarkSolving(solver, size);
+        }
+
+        printf("\nJunction graph (seed 1)\n%-6s %10s %10s %10s %8s %8s %10s %10s %10s %12s %12s\n", "size", "build ms",
+            "nodes", "edges", "cells/nd", "corridor", "dead ends", "bfs ms", "graph ms", "bfs expand", "graph expand");
+        for (int size : sizes) {
+            if (size <= maxSize) benchmarkJunctions(solver, size);
+        }
+
+        sf::RenderTexture target;
+        if (!target.create(1000, 800)) {
+            cout << "Error creating offscreen render target" << std::endl;
+            return 1;
+        }
+        printf("\nRendering (1000x800 offscreen)\n%-6s %12s %12s %12s %12s\n", "size", "build ms", "ms/frame", "draws/frame", "verts/frame");
+        for (int size : sizes) {
+            if (size <= maxSize) benchmarkRendering(target, size);
         }
         return 0;
     }
 };
 
+// Counts streamed rows without storing them
+class NullRowSink : public MazeRowSink {
+public:
+    void consumeRow(long long, const uint8_t*, int) override {}
+};
 
-class Game {
-private:
-    sf::Clock clock;
-    sf::Font font;
-    sf::Text timerText, bestTimeText, countdownText, gameOverText;
+// Streams a width x height Eller maze to a file (or nowhere) in constant memory
+int streamEller(int width, long long height, const char* path, uint64_t seed) {
+    if (width <= 0 || height <= 0) {
+        cout << "Usage: --eller <width> <height> [file] [seed]" << std::endl;
+        return 1;
+    }
 
-    sf::RenderWindow& window;
-    Maze maze;
-    int currentPos = 0;
-    int bestTime = -1;
-    int countdownSeconds;
-    bool showingGameOver = false;
-    sf::Clock freezeClock;
-    int mazesize;
+    FILE* file = nullptr;
+    if (path) {
+        file = fopen(path, "wb");
+        if (!file) {
+            cout << "Error opening " << path << std::endl;
+            return 1;
+        }
+        uint32_t header[2] = { 0x53525A4D, static_cast<uint32_t>(width) };   // "MZRS", width
+        fwrite(header, sizeof(header), 1, file);
+        fwrite(&height, sizeof(height), 1, file);
+    }
 
-    sf::RectangleShape currentHighlight, goalHighlight;
+    FileRowSink fileSink(file);
+    NullRowSink nullSink;
+    Pcg32 rng(seed);
+    EllerStream stream(width);
 
-public:
-    Game(sf::RenderWindow& win, int mazeSize) : window(win), maze(mazeSize),mazesize(mazeSize) {
-        font.loadFromFile("Data/Roboto.ttf");
-       
+    sf::Clock clock;
+    stream.generate(height, rng, file ? static_cast<MazeRowSink&>(fileSink) : nullSink);
+    double seconds = clock.getElapsedTime().asMicroseconds() / 1e6;
+    if (file) fclose(file);
 
-        setupText(timerText, 30, 5, sf::Color::White);
-        setupText(bestTimeText, 150, 5, sf::Color::Yellow);
-        setupText(countdownText, 300, 5, sf::Color::Red);
+    printf("%d x %lld cells in %.3f s: %.0f rows/s, %.0f cells/s, peak RSS %.1f MB\n", width, height, seconds,
+        height / seconds, static_cast<double>(width) * height / seconds, peakMemoryBytes() / 1048576.0);
+    return 0;
+}
 
-        gameOverText.setFont(font);
-        gameOverText.setString("Game Over");
-        gameOverText.setCharacterSize(60);
-        gameOverText.setFillColor(sf::Color::Red);
-        gameOverText.setStyle(sf::Text::Bold);
-        gameOverText.setPosition(200, 200);
+// Generates a maze straight into a grid, without a window, and saves it
+int saveMazeCli(const char* path, int size, uint64_t seed, int generatorId) {
+    if (!path || size <= 0 || static_cast<long long>(size) * size > INT_MAX) {
+        cout << "Usage: --save <file> <size> [seed] [generator]" << std::endl;
+        return 1;
+    }
+    MazeGrid grid(size, size);
+    std::unique_ptr<MazeGenerator> generator = createGenerator(generatorId);
+    Pcg32 rng(seed);
 
-        maze.getCell(currentPos).isActive = true;
+    sf::Clock clock;
+    generator->generate(grid, rng);
+    double generateMs = clock.restart().asMicroseconds() / 1000.0;
+    if (!saveMazeFile(path, grid, seed, generatorId)) return 1;
+    double saveMs = clock.getElapsedTime().asMicroseconds() / 1000.0;
 
-        currentHighlight.setSize({ CELL_WIDTH, CELL_WIDTH });
-        currentHighlight.setFillColor(sf::Color(166, 207, 213));
+    printf("%s: %d x %d %s maze, seed %llu, %.1f MB; generated in %.1f ms, saved in %.1f ms\n", path, size, size,
+        generator->name(), static_cast<unsigned long long>(seed), grid.packedSize() / 1048576.0, generateMs, saveMs);
+    return 0;
+}
 
-        goalHighlight.setSize({ CELL_WIDTH, CELL_WIDTH });
-        goalHighlight.setFillColor(sf::Color(0, 128, 0));
-		if (this->mazesize == 15) {
-			countdownSeconds = 60;
-		}
-		else if (this->mazesize == 25) {
-			countdownSeconds = 90;
-		}
-		else {
-			countdownSeconds = 120;
-		}
+// Maps a maze file and reports its header; --verify also hashes the walls
+int inspectMazeFile(const char* path, bool verify) {
+    if (!path) {
+        cout << "Usage: --info <file> [--verify]" << std::endl;
+        return 1;
     }
+    MazeGrid grid;
+    MazeFileHeader header;
+    sf::Clock clock;
+    if (!loadMazeFile(path, grid, header)) return 1;
+    double loadMs = clock.getElapsedTime().asMicroseconds() / 1000.0;
 
-    void setupText(sf::Text& text, float x, float y, sf::Color color) {
-        text.setFont(font);
-        text.setCharacterSize(20);
-        text.setFillColor(color);
-        text.setPosition(x, y);
+    std::unique_ptr<MazeGenerator> generator = createGenerator(header.generatorId);
+    printf("%s: version %u, %d x %d, %s, seed %llu, walls %.1f MB at offset %llu; mapped and checked in %.3f ms\n", path,
+        header.version, header.width, header.height, generator->name(), static_cast<unsigned long long>(header.seed),
+        header.wallsSize / 1048576.0, static_cast<unsigned long long>(header.wallsOffset), loadMs);
+
+    if (verify) {
+        bool match = grid.hash() == header.wallsHash;
+        printf("walls hash %016llx: %s\n", static_cast<unsigned long long>(header.wallsHash), match ? "ok" : "MISMATCH");
+        if (!match) return 1;
     }
+    return 0;
+}
 
-    void run() {
-        while (window.isOpen()) {
-            handleEvents();
-            update();
-            render();
-        }
+// Batch analysis: mazes generated, solved and measured across a thread pool,
+// one result row per maze streamed to a CSV or binary table. Input lines are
+// "<size> <seed> [generator]" or "<size> <first>-<last> [generator]" for a
+// range of seeds; '#' starts a comment.
+struct BatchRange {
+    int size;
+    int generatorId;
+    uint64_t firstSeed;
+    long long count;
+    long long startIndex;   // row of the first seed in the output
+};
+
+// Binary table: this header, then one BatchRow per maze in input order.
+// Host byte order, like the maze file format.
+#define BATCH_TABLE_MAGIC 0x54425A4D   // "MZBT"
+#define BATCH_TABLE_VERSION 1
+#define BATCH_BLOCK_ROWS 4096
+
+struct BatchTableHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t rowSize;
+    uint32_t reserved;
+    uint64_t rows;
+};
+
+struct BatchRow {
+    uint64_t seed;
+    uint64_t hash;
+    int32_t size;
+    int32_t generatorId;
+    int32_t pathLength;
+    int32_t deadEnds;
+    int32_t decisions;
+    float branching;
+    float difficulty;
+    float generateUs;
+    float analyseUs;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(BatchTableHeader) == 24, "batch table header layout changed");
+static_assert(sizeof(BatchRow) == 56, "batch row layout changed");
+
+// Reads the unsigned decimal at text, which must end at the end of the line or
+// at one of `delimiters`, and moves text past it. Signs, junk and values that
+// overflow uint64 are rejected.
+bool readBatchField(const char*& text, const char* delimiters, uint64_t& value) {
+    while (*text == ' ' || *text == '\t') text++;
+    if (*text < '0' || *text > '9') return false;
+    errno = 0;
+    char* end = nullptr;
+    value = strtoull(text, &end, 10);
+    if (end == text || errno == ERANGE || (*end && !strchr(delimiters, *end))) return false;
+    text = end;
+    return true;
+}
+
+bool readBatchInput(const char* path, vector<BatchRange>& ranges, long long& total) {
+    bool useStdin = string(path) == "-";
+    FILE* file = useStdin ? stdin : fopen(path, "r");
+    if (!file) {
+        cout << "Error: could not open batch input " << path << std::endl;
+        return false;
     }
+    const char* space = " \t\r\n";
+    char line[256];
+    int lineNumber = 0;
+    bool ok = true;
+    total = 0;
+    while (ok && fgets(line, sizeof(line), file)) {
+        lineNumber++;
+        char* comment = strchr(line, '#');
+        if (comment) *comment = 0;
+        const char* text = line + strspn(line, space);
+        if (!*text) continue;
 
-private:
-    void handleEvents() {
-        sf::Event event;
-        while (window.pollEvent(event)) {
-            if (event.type == sf::Event::Closed) window.close();
-            if (event.type == sf::Event::KeyPressed && !showingGameOver) handleMovement(event.key.code);
+        // <size> <seed|first-last> [generator]
+        uint64_t size = 0, first = 0, last = 0, generatorId = GEN_BACKTRACKER;
+        bool valid = readBatchField(text, space, size) && readBatchField(text, "- \t\r\n", first);
+        last = first;
+        if (valid && *text == '-') valid = readBatchField(++text, space, last);
+        text += strspn(text, space);
+        if (valid && *text) valid = readBatchField(text, space, generatorId);
+        text += strspn(text, space);
+        if (!valid || *text || size < 2 || size > 8192 || last < first || generatorId >= GENERATOR_COUNT) {
+            cout << "Error: batch input line " << lineNumber << " should be <size 2-8192> <seed|first-last> [generator]" << std::endl;
+            ok = false;
+            break;
+        }
+        if (last - first >= static_cast<uint64_t>(LLONG_MAX - total)) {
+            cout << "Error: batch input line " << lineNumber << " asks for too many seeds" << std::endl;
+            ok = false;
+            break;
         }
+        long long count = static_cast<long long>(last - first) + 1;
+        ranges.push_back({ static_cast<int>(size), static_cast<int>(generatorId), first, count, total });
+        total += count;
     }
+    if (!useStdin) fclose(file);
+    return ok;
+}
 
-    void handleMovement(sf::Keyboard::Key key) {
-        Cell& current = maze.getCell(currentPos);
-        int size = maze.getSize();
+// Streams rows to disk in input order; the format follows the file extension
+class BatchWriter {
+private:
+    FILE* file = nullptr;
+    bool csv = false;
+    long long written = 0;
+    const char* generatorNames[GENERATOR_COUNT] = {};
 
-        int next = -1;
-        if ((key == sf::Keyboard::Left || key == sf::Keyboard::H) && !current.walls[3]) next = currentPos - 1;
-        else if ((key == sf::Keyboard::Right || key == sf::Keyboard::L) && !current.walls[1]) next = currentPos + 1;
-        else if ((key == sf::Keyboard::Up || key == sf::Keyboard::K) && currentPos >= size && !current.walls[0]) next = currentPos - size;
-        else if ((key == sf::Keyboard::Down || key == sf::Keyboard::J) && currentPos + size < size * size && !current.walls[2]) next = currentPos + size;
+public:
+    ~BatchWriter() { close(); }
 
-        if (next >= 0 && next < size * size) {
-            current.isActive = false;
-            currentPos = next;
-            maze.getCell(currentPos).isActive = true;
+    bool open(const char* path, long long rows) {
+        for (int id = 0; id < GENERATOR_COUNT; id++) generatorNames[id] = createGenerator(id)->name();
+        size_t length = strlen(path);
+        csv = length >= 4 && strcmp(path + length - 4, ".csv") == 0;
+        file = fopen(path, csv ? "w" : "wb");
+        if (!file) {
+            cout << "Error: could not create " << path << std::endl;
+            return false;
         }
-
-		if (key == sf::Keyboard::Escape) {
-			showingGameOver = true;
-			freezeClock.restart();
-			GameOverScreen gameOverScreen(window);
-			int result = gameOverScreen.run();
-			if (result == 1) restartGame(); // Play Again
-			else if (result == -1) window.close(); // Exit
-		}
-
+        if (csv) {
+            fprintf(file, "index,size,generator,seed,hash,path_length,dead_ends,decisions,branching,difficulty,generate_us,analyse_us\n");
+        }
+        else {
+            BatchTableHeader header = { BATCH_TABLE_MAGIC, BATCH_TABLE_VERSION, sizeof(BatchRow), 0, static_cast<uint64_t>(rows) };
+            fwrite(&header, sizeof(header), 1, file);
+        }
+        return true;
     }
 
-    void update() {
-        if (showingGameOver) {
-            if (freezeClock.getElapsedTime().asSeconds() > 3.0f) restartGame();
+    void write(const BatchRow* rows, int count) {
+        if (!csv) {
+            fwrite(rows, sizeof(BatchRow), count, file);
+            written += count;
             return;
         }
+        for (int i = 0; i < count; i++) {
+            const BatchRow& row = rows[i];
+            fprintf(file, "%lld,%d,%s,%llu,%016llx,%d,%d,%d,%.3f,%.2f,%.1f,%.1f\n", written++, row.size,
+                generatorNames[row.generatorId], static_cast<unsigned long long>(row.seed),
+                static_cast<unsigned long long>(row.hash), row.pathLength, row.deadEnds, row.decisions, row.branching,
+                row.difficulty, row.generateUs, row.analyseUs);
+        }
+    }
 
-        if (currentPos == maze.getSize() * maze.getSize() - 1) {
-            int elapsed = static_cast<int>(clock.getElapsedTime().asSeconds());
-            if (bestTime == -1 || elapsed < bestTime) bestTime = elapsed;
+    void close() {
+        if (file) fclose(file);
+        file = nullptr;
+    }
+};
 
-            // Show Congratulations screen
-            CongratulationsScreen congratsScreen(window);
-            int result = congratsScreen.run();
-            if (result == 1) restartGame(); // Play Again
-            else if (result == -1) window.close(); // Exit
-        }
+// Per-thread buffers, reused by every maze that thread analyses
+struct BatchScratch {
+    MazeGrid grid;
+    JunctionGraph graph;
+    std::unique_ptr<MazeGenerator> generators[GENERATOR_COUNT];
+};
 
-        int seconds = static_cast<int>(clock.getElapsedTime().asSeconds());
-        int remaining = countdownSeconds - seconds;
+void analyseBatchMaze(const BatchRange& range, long long offset, BatchRow& row) {
+    static thread_local BatchScratch scratch;
+    std::unique_ptr<MazeGenerator>& generator = scratch.generators[range.generatorId];
+    if (!generator) generator = createGenerator(range.generatorId);
 
-        timerText.setString("Time: " + std::to_string(seconds) + "s");
-        bestTimeText.setString("Best: " + (bestTime != -1 ? std::to_string(bestTime) + "s" : "--"));
-        countdownText.setString(remaining >= 0 ? "Countdown: " + std::to_string(remaining) + "s" : "Time's up!");
+    sf::Clock clock;
+    row = BatchRow();
+    row.seed = range.firstSeed + static_cast<uint64_t>(offset);
+    row.size = range.size;
+    row.generatorId = range.generatorId;
+    if (scratch.grid.getWidth() != range.size) scratch.grid.resize(range.size, range.size);
+    else scratch.grid.reset();
+    Pcg32 rng(row.seed);
+    generator->generate(scratch.grid, rng);
+    row.generateUs = clock.restart().asMicroseconds();
 
-        if (remaining < 0 && !showingGameOver) {
-            showingGameOver = true;
-            freezeClock.restart();
+    MazeMetrics metrics = measureMaze(scratch.grid, scratch.graph);
+    row.hash = scratch.grid.hash();
+    row.pathLength = metrics.pathLength;
+    row.deadEnds = metrics.deadEnds;
+    row.decisions = metrics.decisions;
+    row.branching = static_cast<float>(metrics.branching);
+    row.difficulty = static_cast<float>(metrics.difficulty);
+    row.analyseUs = clock.getElapsedTime().asMicroseconds();
+}
 
-            // Show Game Over screen
-            GameOverScreen gameOverScreen(window);
-            int result = gameOverScreen.run();
-            if (result == 1) restartGame(); // Play Again
-            else if (result == -1) window.close(); // Exit
-        }
+// Runs the batch a block of rows at a time: the block is spread over the pool,
+// then written in order while memory stays at one block of rows
+int runBatch(const char* inputPath, const char* outputPath, int threads) {
+    if (!inputPath || !outputPath) {
+        cout << "Usage: --batch <input|-> <output.csv|output.bin> [threads]" << std::endl;
+        return 1;
+    }
+    vector<BatchRange> ranges;
+    long long total = 0;
+    if (!readBatchInput(inputPath, ranges, total)) return 1;
+    if (total == 0) {
+        cout << "Error: batch input " << inputPath << " lists no mazes" << std::endl;
+        return 1;
     }
 
-    void render() {
-        window.clear(sf::Color(13, 2, 33));
-        maze.draw(window);
+    BatchWriter writer;
+    if (!writer.open(outputPath, total)) return 1;
 
-        currentHighlight.setPosition(maze.getCell(currentPos).x, maze.getCell(currentPos).y);
-        window.draw(currentHighlight);
+    // parallelFor's caller works too, so a pool of threads - 1 gives `threads` in all
+    std::unique_ptr<ThreadPool> ownPool;
+    if (threads > 1) ownPool = std::make_unique<ThreadPool>(threads - 1);
+    ThreadPool* pool = threads > 1 ? ownPool.get() : threads == 1 ? nullptr : &sharedPool();
 
-        goalHighlight.setPosition(maze.getCell(maze.getSize() * maze.getSize() - 1).x,
-            maze.getCell(maze.getSize() * maze.getSize() - 1).y);
-        window.draw(goalHighlight);
+    vector<BatchRow> rows(BATCH_BLOCK_ROWS);
+    long long cells = 0;
+    sf::Clock clock;
+    for (long long blockStart = 0; blockStart < total; blockStart += BATCH_BLOCK_ROWS) {
+        int count = static_cast<int>(std::min<long long>(BATCH_BLOCK_ROWS, total - blockStart));
+        auto job = [&](int i) {
+            long long index = blockStart + i;
+            auto range = std::upper_bound(ranges.begin(), ranges.end(), index,
+                [](long long value, const BatchRange& r) { return value < r.startIndex; }) - 1;
+            analyseBatchMaze(*range, index - range->startIndex, rows[i]);
+        };
+        if (pool) pool->parallelFor(count, job);
+        else for (int i = 0; i < count; i++) job(i);
 
-        window.draw(timerText);
-        window.draw(bestTimeText);
-        window.draw(countdownText);
-        if (showingGameOver) window.draw(gameOverText);
+        for (int i = 0; i < count; i++) cells += static_cast<long long>(rows[i].size) * rows[i].size;
+        writer.write(rows.data(), count);
+    }
+    writer.close();
+    double seconds = std::max(clock.getElapsedTime().asMicroseconds() / 1e6, 1e-9);
 
-        window.display();
+    printf("%lld mazes, %lld cells in %.3f s on %d threads: %.0f mazes/s, %.0f cells/s\n", total, cells, seconds,
+        pool ? pool->size() + 1 : 1, total / seconds, cells / seconds);
+    return 0;
+}
+
+// Shows what calibration picks for a level, to tune bands and the countdown
+int calibrateCli(int size, int generatorId, uint64_t seed) {
+    if (size <= 1 || generatorId < 0 || generatorId >= GENERATOR_COUNT) {
+        cout << "Usage: --calibrate <size> [gen] [seed]" << std::endl;
+        return 1;
     }
+    DifficultyBand band = difficultyBandFor(size);
+    CalibrationResult result = calibrateMaze(size, generatorId, seed, band);
+    const MazeMetrics& m = result.chosen;
+    printf("%dx%d %s, band %.0f-%.0f%%: %d candidates in %.2f ms\n", size, size, createGenerator(generatorId)->name(),
+        band.low * 100, band.high * 100, result.measured, result.milliseconds);
+    printf("seed %llu: path %d, dead ends %d, decisions %d, branching %.2f, difficulty %.1f, countdown %ds\n",
+        static_cast<unsigned long long>(m.seed), m.pathLength, m.deadEnds, m.decisions, m.branching, m.difficulty,
+        GameCore::countdownFor(m.pathLength));
+    return 0;
+}
 
-    void restartGame() {
-        maze.generateMaze();
-        currentPos = 0;
-        maze.getCell(currentPos).isActive = true;
-        clock.restart();
-        showingGameOver = false;
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        Benchmark benchmark(argc > 2 ? atoi(argv[2]) : 8192);
+        return benchmark.run();
+    }
+    if (argc > 1 && string(argv[1]) == "--eller") {
+        int width = argc > 2 ? atoi(argv[2]) : 0;
+        long long height = argc > 3 ? atoll(argv[3]) : 0;
+        const char* path = argc > 4 ? argv[4] : nullptr;
+        uint64_t seed = argc > 5 ? strtoull(argv[5], nullptr, 10) : 1;
+        return streamEller(width, height, path, seed);
+    }
+    if (argc > 1 && string(argv[1]) == "--save") {
+        const char* path = argc > 2 ? argv[2] : nullptr;
+        int size = argc > 3 ? atoi(argv[3]) : 0;
+        uint64_t seed = argc > 4 ? strtoull(argv[4], nullptr, 10) : 1;
+        int generatorId = argc > 5 ? atoi(argv[5]) : GEN_BACKTRACKER;
+        if (generatorId < 0 || generatorId >= GENERATOR_COUNT) generatorId = GEN_BACKTRACKER;
+        return saveMazeCli(path, size, seed, generatorId);
+    }
+    if (argc > 1 && string(argv[1]) == "--simulate") {
+        int games = argc > 2 ? atoi(argv[2]) : 0;
+        int size = argc > 3 ? atoi(argv[3]) : 15;
+        int policy = argc > 4 ? atoi(argv[4]) : BOT_SHORTEST;
+        double movesPerSecond = argc > 5 ? atof(argv[5]) : 8.0;
+        uint64_t seed = argc > 6 ? strtoull(argv[6], nullptr, 10) : 1;
+        return simulateGames(games, size, policy, movesPerSecond, seed);
+    }
+    if (argc > 1 && string(argv[1]) == "--batch") {
+        return runBatch(argc > 2 ? argv[2] : nullptr, argc > 3 ? argv[3] : nullptr, argc > 4 ? atoi(argv[4]) : 0);
+    }
+    if (argc > 1 && string(argv[1]) == "--calibrate") {
+        int size = argc > 2 ? atoi(argv[2]) : 0;
+        int generatorId = argc > 3 ? atoi(argv[3]) : GEN_BACKTRACKER;
+        uint64_t seed = argc > 4 ? strtoull(argv[4], nullptr, 10) : 1;
+        return calibrateCli(size, generatorId, seed);
+    }
+    if (argc > 1 && string(argv[1]) == "--info") {
+        return inspectMazeFile(argc > 2 ? argv[2] : nullptr, argc > 3 && string(argv[3]) == "--verify");
     }
-};
 
-int main() {
+    // Session options: --trace <file.csv|file.json> records every frame,
+    // --record <log> writes the commands played and --replay <log> plays them
+    // back, --fast without frame pacing and --headless without a window;
+    // --report-allocations prints every steady-state frame that hit the heap
+    const char* tracePath = nullptr;
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    bool fast = false, headless = false, reportAllocations = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--trace" && i + 1 < argc) tracePath = argv[++i];
+        else if (arg == "--record" && i + 1 < argc) recordPath = argv[++i];
+        else if (arg == "--replay" && i + 1 < argc) replayPath = argv[++i];
+        else if (arg == "--fast") fast = true;
+        else if (arg == "--headless") headless = true;
+        else if (arg == "--report-allocations") reportAllocations = true;
+    }
+#ifndef COUNT_ALLOCATIONS
+    if (reportAllocations) {
+        cout << "Error: --report-allocations needs a build with COUNT_ALLOCATIONS" << std::endl;
+        return 1;
+    }
+#endif
+    if (replayPath && headless) return replayHeadless(replayPath, !fast);
+    if (tracePath && !profiler.openTrace(tracePath)) return 1;
+
+    SessionRecorder recorder;
+    SessionReplay replay;
+    if (recordPath && !recorder.open(recordPath)) return 1;
+    if (replayPath && !replay.load(replayPath)) return 1;
+
+    // Start reading assets while the window opens; screens then share them
+    resources().preloadAll();
+
     sf::RenderWindow window(sf::VideoMode(1000, 800), "Maze Game");
-    window.setFramerateLimit(60);
+    window.setFramerateLimit(replayPath && fast ? 0 : 60);
 
-    Lobby lobby(window);
-    if (lobby.run()) {
-        LevelSelector selector(window);
-        int size = selector.run();
-        if (size > 0) {
-            Game game(window, size);
-            game.run();
-        }
+    SceneManager scenes(window);
+    scenes.setAllocationReport(reportAllocations);
+    if (replayPath) {
+        scenes.setLockstep(fast);
+        scenes.push(std::make_unique<Game>(scenes, replay.peek().size, nullptr, &replay));
+        scenes.run();
+        return 0;
     }
+
+    // Lobby -> level selection -> game, each replacing the previous screen
+    SessionRecorder* log = recordPath ? &recorder : nullptr;
+    scenes.push(std::make_unique<Lobby>(scenes, [&scenes, log]() {
+        scenes.replace(std::make_unique<LevelSelector>(scenes, [&scenes, log](int size) {
+            if (size == 0) scenes.replace(std::make_unique<EndlessGame>(scenes));
+            else scenes.replace(std::make_unique<Game>(scenes, size, log));
+        }));
+    }));
+    scenes.run();
     return 0;
 }